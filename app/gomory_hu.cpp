@@ -0,0 +1,86 @@
+/******************************************************************************
+ * gomory_hu.cpp
+ *
+ * Source of VieCut
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#include <omp.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "algorithms/flow/gomory_hu.h"
+#include "common/configuration.h"
+#include "data_structure/gomory_hu_tree.h"
+#include "data_structure/graph_access.h"
+#include "data_structure/mutable_graph.h"
+#include "io/graph_io.h"
+#include "tlx/cmdline_parser.hpp"
+#include "tools/string.h"
+#include "tools/timer.h"
+
+int main(int argn, char** argv) {
+    tlx::CmdlineParser cmdl;
+    auto cfg = configuration::getConfig();
+    std::string query_file = "";
+
+    cmdl.add_param_string("graph", cfg->graph_filename, "path to graph file");
+    cmdl.add_size_t('p', "proc", cfg->threads, "number of threads");
+    cmdl.add_string('o', "output_path", cfg->output_path,
+                    "write Gomory-Hu tree to file");
+    cmdl.add_string('q', "queries", query_file,
+                    "file with vertex pairs, prints their connectivity");
+
+    if (!cmdl.process(argn, argv))
+        return -1;
+
+    omp_set_num_threads(cfg->threads);
+
+    timer t;
+    std::shared_ptr<graph_access> G =
+        graph_io::readGraphWeighted(cfg->graph_filename);
+    LOG1 << "io time: " << t.elapsed();
+
+    t.restart();
+    auto mG = mutable_graph::from_graph_access(G);
+    gomory_hu gh;
+    std::shared_ptr<gomory_hu_tree> tree = gh.buildTree(mG);
+
+    std::cout << "RESULT algo=gomory_hu graph="
+              << string::basename(cfg->graph_filename)
+              << " time=" << t.elapsed()
+              << " n=" << G->number_of_nodes()
+              << " m=" << G->number_of_edges() / 2
+              << " processes=" << cfg->threads << std::endl;
+
+    if (cfg->output_path != "") {
+        tree->writeTree(cfg->output_path);
+    }
+
+    if (query_file != "") {
+        std::ifstream f(query_file.c_str());
+        if (!f) {
+            LOG1 << "Error opening file " << query_file;
+            exit(1);
+        }
+
+        NodeID u, v;
+        while (f >> u >> v) {
+            if (u >= tree->number_of_nodes() || v >= tree->number_of_nodes()) {
+                LOG1 << "Error: vertex pair " << u << " " << v
+                     << " out of range";
+                exit(1);
+            }
+            std::cout << u << " " << v << " " << tree->connectivity(u, v)
+                      << std::endl;
+        }
+    }
+}
@@ -17,7 +17,7 @@
 #include <sstream>
 
 #include "algorithms/global_mincut/minimum_cut_helpers.h"
-#include "algorithms/misc/strongly_connected_components.h"
+#include "algorithms/misc/connected_components.h"
 #include "data_structure/graph_access.h"
 #include "io/graph_io.h"
 #include "tlx/cmdline_parser.hpp"
@@ -42,8 +42,8 @@ int main(int argn, char** argv) {
     std::shared_ptr<graph_access> G =
         graph_io::readGraphWeighted(path);
 
-    strongly_connected_components scc;
+    connected_components cc;
 
-    auto out = scc.largest_scc(G);
+    auto out = cc.largest_cc(G);
     graph_io::writeGraph(out, tlx::split(".", path)[0] + ".cc");
 }
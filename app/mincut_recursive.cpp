@@ -23,7 +23,7 @@
 #include "algorithms/global_mincut/noi_minimum_cut.h"
 #endif
 #include "algorithms/global_mincut/viecut.h"
-#include "algorithms/misc/strongly_connected_components.h"
+#include "algorithms/misc/connected_components.h"
 #include "data_structure/graph_access.h"
 #include "io/graph_io.h"
 #include "tlx/cmdline_parser.hpp"
@@ -77,12 +77,12 @@ int main(int argn, char** argv) {
         size_t larger = (G->number_of_nodes() < inside * 2) ? 1 : 0;
 
         graph_extractor ge;
-        strongly_connected_components scc;
+        connected_components cc;
 
         graphs.emplace_back(ge.extract_block(G, larger).first);
         std::shared_ptr<graph_access> new_g = graphs.back();
 
-        graphs.emplace_back(scc.largest_scc(new_g));
+        graphs.emplace_back(cc.largest_cc(new_g));
         if (cut > last_cut && last_cut != 0 && cut <
             G->getMinDegree() && output) {
             graph_io::writeGraph(G, graph_filename + "_" + std::to_string(cut));
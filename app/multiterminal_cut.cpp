@@ -27,6 +27,7 @@
 #include <memory>
 #include <sstream>
 
+#include "algorithms/misc/connected_components.h"
 #include "algorithms/multicut/multicut_problem.h"
 #include "algorithms/multicut/multiterminal_cut.h"
 #include "data_structure/graph_access.h"
@@ -68,10 +69,41 @@ int main(int argn, char** argv) {
                     "Partition file");
     cmdl.add_bool('N', "no_branching", config->noBranching,
                   "don't branch, but just write graph (for tests)");
+    cmdl.add_bool('I', "isolating_cuts", config->use_isolating_cuts,
+                  "compute isolating cuts with O(log k) flows");
+    cmdl.add_size_t('M', "memory_budget", config->memory_budget,
+                    "memory budget in GB, problems above it go to disk");
+    cmdl.add_string('S', "spill_path", config->spill_path,
+                    "directory for problems spilled to disk");
+    cmdl.add_string('C', "checkpoint", config->checkpoint_file,
+                    "periodically write search state to this file");
+    cmdl.add_double('i', "checkpoint_interval", config->checkpoint_interval,
+                    "seconds between two checkpoints");
+    cmdl.add_double('T', "time_limit", config->time_limit,
+                    "time limit in seconds");
+    cmdl.add_bool('R', "resume", config->resume,
+                  "continue from checkpoint file");
+    cmdl.add_size_t('H', "transposition_log_size",
+                    config->transposition_log_size,
+                    "log2 of transposition table size, 0 to disable");
+    cmdl.add_size_t('L', "heuristic_iterations", config->heuristic_iterations,
+                    "iterated local search rounds, 0 to disable");
+    cmdl.add_double('u', "heuristic_interval", config->heuristic_interval,
+                    "seconds between two primal heuristic runs");
 
     if (!cmdl.process(argn, argv))
         return -1;
 
+    if (config->resume && config->checkpoint_file.empty()) {
+        LOG1 << "Error: --resume needs a checkpoint file (-C)";
+        return -1;
+    }
+
+    if (!config->checkpoint_file.empty()) {
+        LOG1 << "Checkpointing: subproblems are not split into "
+             << "connected components";
+    }
+
     // MallocExtension::instance()->SetMemoryReleaseRate(0.0);
 
     random_functions::setSeed(config->seed);
@@ -132,8 +164,8 @@ int main(int argn, char** argv) {
             num_terminals = num_partitions;
             config->total_terminals = num_terminals;
 
-            strongly_connected_components cc;
-            auto [components, num_comp] = cc.strong_components(G);
+            connected_components cc;
+            auto [components, num_comp] = cc.find_components(G);
 
             std::vector<NodeID> v =
                 graph_io::readVector<NodeID>(config->partition_file);
@@ -217,6 +249,10 @@ int main(int argn, char** argv) {
     multiterminal_cut mc;
     timer t;
     FlowType flow = mc.multicut(G, terminals);
+    if (mc.timedOut()) {
+        LOG1 << "RESULT Timeout!";
+        exit(1);
+    }
     std::cout << "RESULT selection_rule=" << config->edge_selection
               << " pq=" << config->queue_type
               << " contraction_type=" << config->contraction_type
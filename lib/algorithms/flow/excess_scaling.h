@@ -62,18 +62,13 @@ class excess_scaling {
         while (m_mu > 4) {
             size_t discard = 0;
             unit_flow uf;
-            uf.init(*m_fg, flowsrc, m_U, m_max_height, 2);
+            uf.init(m_fg, flowsrc, m_U, m_max_height, 2);
             uf.run();
             size_t ctr = 0;
 
             for (NodeID n : m_fg->nodes()) {
                 for (EdgeID e : m_fg->edges_of(n)) {
-                    EdgeID rev = m_fg->getReverseEdge(n, e);
-                    NodeID tgt = m_fg->getEdgeTarget(n, e);
-
                     m_flows[ctr++] += m_fg->getEdgeFlow(n, e) * m_mu;
-                    m_fg->setEdgeFlow(n, e, 0);
-                    m_fg->setEdgeFlow(tgt, rev, 0);
                 }
 
                 if (uf.excess(n) > 0) {
@@ -82,6 +77,7 @@ class excess_scaling {
                     flowsrc[n] = m_delta_src[n] / m_mu;
                 }
             }
+            m_fg->resetFlow();
             m_mu /= 2;
         }
     }
@@ -0,0 +1,115 @@
+/******************************************************************************
+ * gomory_hu.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "algorithms/flow/push_relabel.h"
+#include "common/definitions.h"
+#include "data_structure/gomory_hu_tree.h"
+#include "data_structure/mutable_graph.h"
+#include "tlx/logger.hpp"
+#include "tools/timer.h"
+
+// Gomory-Hu tree using Gusfield's algorithm, which computes n - 1 minimum
+// cuts in the original graph and needs no contraction. The cut of vertex s
+// is taken between s and its parent at the time s is processed.
+//
+// As all cuts are computed on the same graph, the cuts of a batch of
+// vertices are computed in parallel with the parents at the start of the
+// batch. The cuts are then applied in order. If the parent of a vertex was
+// changed by an earlier vertex of the batch, its cut is recomputed using
+// all threads.
+class gomory_hu {
+ public:
+    static constexpr bool debug = false;
+
+    gomory_hu() { }
+    virtual ~gomory_hu() { }
+
+    std::shared_ptr<gomory_hu_tree> buildTree(
+        std::shared_ptr<mutable_graph> G) {
+        timer t;
+        NodeID n = G->number_of_nodes();
+        std::vector<NodeID> parent(n, 0);
+        std::vector<EdgeWeight> weight(n, 0);
+
+        size_t threads = omp_get_max_threads();
+        std::vector<push_relabel> solvers(threads);
+        std::vector<FlowType> batch_flow(threads);
+        std::vector<std::vector<NodeID> > batch_cut(threads);
+        std::vector<NodeID> batch_parent(threads);
+        std::vector<NodeID> cut_of(n, UNDEFINED_NODE);
+        size_t recomputed = 0;
+
+        for (NodeID first = 1; first < n; first += threads) {
+            NodeID last = std::min(static_cast<size_t>(n), first + threads);
+
+#pragma omp parallel for schedule(dynamic, 1)
+            for (NodeID s = first; s < last; ++s) {
+                push_relabel& pr = solvers[omp_get_thread_num()];
+                batch_parent[s - first] = parent[s];
+                std::tie(batch_flow[s - first], batch_cut[s - first]) =
+                    minimumCut(&pr, G, s, parent[s], 1);
+            }
+
+            for (NodeID s = first; s < last; ++s) {
+                NodeID t = parent[s];
+                if (t != batch_parent[s - first]) {
+                    recomputed++;
+                    std::tie(batch_flow[s - first], batch_cut[s - first]) =
+                        minimumCut(&solvers[0], G, s, t, threads);
+                }
+
+                FlowType flow = batch_flow[s - first];
+                const std::vector<NodeID>& cut = batch_cut[s - first];
+                for (NodeID v : cut) {
+                    cut_of[v] = s;
+                }
+
+                weight[s] = flow;
+                for (NodeID v : cut) {
+                    if (v != s && parent[v] == t) {
+                        parent[v] = s;
+                    }
+                }
+
+                if (cut_of[parent[t]] == s) {
+                    parent[s] = parent[t];
+                    parent[t] = s;
+                    weight[s] = weight[t];
+                    weight[t] = flow;
+                }
+            }
+        }
+
+        LOG << "Gomory-Hu tree of " << n << " vertices with " << recomputed
+            << " recomputed cuts in " << t.elapsed() << "s";
+
+        return std::make_shared<gomory_hu_tree>(parent, weight);
+    }
+
+ private:
+    // minimum cut between s and t and the side of s
+    std::pair<FlowType, std::vector<NodeID> > minimumCut(
+        push_relabel* pr, std::shared_ptr<mutable_graph> G,
+        NodeID s, NodeID t, size_t threads) {
+        std::vector<NodeID> terminals = { s, t };
+        return pr->solve_max_flow_min_cut(G, terminals, 0, true, true,
+                                          threads);
+    }
+};
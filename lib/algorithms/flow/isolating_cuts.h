@@ -0,0 +1,183 @@
+/******************************************************************************
+ * isolating_cuts.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "algorithms/flow/push_relabel.h"
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "tlx/logger.hpp"
+
+// Minimum isolating cuts of all terminals with O(log k) maximum flows on the
+// whole graph (Li and Panigrahi, FOCS'20):
+//
+// For every bit of the terminal indices, a minimum cut separates the
+// terminals where the bit is set from the terminals where it is not set.
+// Vertices that are on the side of terminal t in all of these cuts form the
+// region U_t. The regions are disjoint and U_t contains a minimum isolating
+// cut of t, which is found by a flow from t to the contracted complement of
+// U_t. As the regions are disjoint, these flows have total size O(m).
+class isolating_cuts {
+ public:
+    static constexpr bool debug = false;
+
+    isolating_cuts() : m_num_flows(0) { }
+    virtual ~isolating_cuts() { }
+
+    // side of a minimum isolating cut for every terminal. the sides are
+    // disjoint. num_threads is used for the flows on the whole graph.
+    std::vector<std::vector<NodeID> > computeIsolatingCuts(
+        std::shared_ptr<mutable_graph> G,
+        const std::vector<NodeID>& terminals,
+        size_t num_threads = 1) {
+        NodeID n = G->number_of_nodes();
+        NodeID k = terminals.size();
+        std::vector<std::vector<NodeID> > cuts(k);
+        m_num_flows = 0;
+        if (k < 2) {
+            for (NodeID i = 0; i < k; ++i) {
+                cuts[i] = { terminals[i] };
+            }
+            return cuts;
+        }
+
+        // code[v] has bit i set if v is not on the side of the terminals
+        // without bit i. vertices in U_t have the index of t as code.
+        std::vector<NodeID> code(n, 0);
+        for (NodeID bit = 1; bit < k; bit <<= 1) {
+            std::vector<bool> side = splitTerminals(G, terminals, bit,
+                                                    num_threads);
+            for (NodeID v = 0; v < n; ++v) {
+                if (!side[v]) {
+                    code[v] |= bit;
+                }
+            }
+        }
+
+        // vertices of each region
+        std::vector<std::vector<NodeID> > region(k);
+        for (NodeID v = 0; v < n; ++v) {
+            if (code[v] < k) {
+                region[code[v]].emplace_back(v);
+            }
+        }
+
+        m_local_id.assign(n, UNDEFINED_NODE);
+        for (NodeID i = 0; i < k; ++i) {
+            VIECUT_ASSERT_EQ(code[terminals[i]], i);
+            cuts[i] = isolateInRegion(G, terminals[i], region[i]);
+        }
+
+        LOG << "isolating cuts of " << k << " terminals with "
+            << m_num_flows << " flows";
+        return cuts;
+    }
+
+ private:
+    // minimum cut between the terminals without and with bit set. returns
+    // for every vertex whether it is on the side of the terminals without
+    // the bit
+    std::vector<bool> splitTerminals(std::shared_ptr<mutable_graph> G,
+                                     const std::vector<NodeID>& terminals,
+                                     NodeID bit, size_t num_threads) {
+        NodeID n = G->number_of_nodes();
+        std::vector<NodeID> mapping(n, UNDEFINED_NODE);
+        for (NodeID i = 0; i < terminals.size(); ++i) {
+            mapping[terminals[i]] = (i & bit) ? 1 : 0;
+        }
+
+        NodeID num_blocks = 2;
+        std::vector<NodeID> vertex_of_block = { UNDEFINED_NODE,
+                                                UNDEFINED_NODE };
+        for (NodeID v = 0; v < n; ++v) {
+            if (mapping[v] == UNDEFINED_NODE) {
+                mapping[v] = num_blocks++;
+                vertex_of_block.emplace_back(v);
+            }
+        }
+
+        auto H = std::make_shared<mutable_graph>(*G);
+        H->contractPartition(mapping, num_blocks);
+
+        std::vector<NodeID> flow_terminals = { 0, 1 };
+        std::vector<NodeID> source_set = m_flow.solve_max_flow_min_cut(
+            H, flow_terminals, 0, true, true, num_threads).second;
+        m_num_flows++;
+
+        std::vector<bool> side(n, false);
+        for (NodeID b : source_set) {
+            if (b > 1) {
+                side[vertex_of_block[b]] = true;
+            }
+        }
+        for (NodeID i = 0; i < terminals.size(); ++i) {
+            side[terminals[i]] = !(i & bit);
+        }
+        return side;
+    }
+
+    // minimum isolating cut of terminal t inside its region, the vertices
+    // outside of the region are contracted into the sink
+    std::vector<NodeID> isolateInRegion(std::shared_ptr<mutable_graph> G,
+                                        NodeID t,
+                                        const std::vector<NodeID>& region) {
+        if (region.size() == 1) {
+            return region;
+        }
+
+        NodeID sink = region.size();
+        for (NodeID i = 0; i < region.size(); ++i) {
+            m_local_id[region[i]] = i;
+        }
+
+        auto H = std::make_shared<mutable_graph>();
+        H->start_construction(region.size() + 1);
+        for (NodeID i = 0; i < region.size(); ++i) {
+            NodeID v = region[i];
+            EdgeWeight to_sink = 0;
+            for (EdgeID e : G->edges_of(v)) {
+                NodeID target = G->getEdgeTarget(v, e);
+                NodeID local = m_local_id[target];
+                if (local == UNDEFINED_NODE) {
+                    to_sink += G->getEdgeWeight(v, e);
+                } else if (i < local) {
+                    H->new_edge(i, local, G->getEdgeWeight(v, e));
+                }
+            }
+            if (to_sink > 0) {
+                H->new_edge(i, sink, to_sink);
+            }
+        }
+        H->finish_construction();
+
+        std::vector<NodeID> flow_terminals = { m_local_id[t], sink };
+        std::vector<NodeID> source_set = m_flow.solve_max_flow_min_cut(
+            H, flow_terminals, 0, true, true).second;
+        m_num_flows++;
+
+        std::vector<NodeID> cut;
+        for (NodeID i : source_set) {
+            cut.emplace_back(region[i]);
+        }
+
+        for (NodeID v : region) {
+            m_local_id[v] = UNDEFINED_NODE;
+        }
+        return cut;
+    }
+
+    push_relabel m_flow;
+    std::vector<NodeID> m_local_id;
+    size_t m_num_flows;
+};
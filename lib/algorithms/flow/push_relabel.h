@@ -14,10 +14,13 @@
 
 #pragma once
 
+#include <omp.h>
+
 #include <algorithm>
 #include <iostream>
 #include <memory>
 #include <queue>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -28,154 +31,376 @@
 const int WORK_OP_RELABEL = 9;
 const double GLOBAL_UPDATE_FRQ = 0.51;
 const int WORK_NODE_TO_EDGES = 4;
+// smaller instances are not worth the synchronization of the parallel solver
+const EdgeID PARALLEL_FLOW_MIN_EDGES = 1000000;
+
+// flow on the edges of a graph, stored by original vertices (see
+// mutable_graph::containedVertex), so that it can be transferred to the
+// graph after contractions and edge deletions
+struct flow_snapshot {
+    // (tail, head, flow) for every edge with positive flow
+    std::vector<std::tuple<NodeID, NodeID, FlowType> > edges;
+};
 
+// Highest-label push-relabel algorithm with global relabeling and gap
+// heuristic. Active vertices are kept in buckets by distance label, all
+// vertices with label < n are also kept in doubly linked lists per label,
+// so that a gap only touches the vertices above it.
+//
+// The first phase computes a maximum preflow, which already determines the
+// minimum cut. The second phase returns the remaining excess to the source
+// to obtain a maximum flow and can be skipped if only the cut is needed.
+//
+// If more than one thread is given and the graph is large, the first phase
+// instead runs in synchronous rounds: all active vertices push in parallel,
+// then all vertices with remaining excess relabel with respect to the labels
+// of the previous round. Global relabeling is a parallel bfs and replaces
+// the gap heuristic.
+//
+// A flow can be warm started from the flow of a related problem, e.g. the
+// same terminal on a graph where some edges were contracted or deleted.
+// Flows on edges that no longer exist are dropped and the resulting
+// deficits are repaired locally by reducing outgoing flow.
+//
+// All arrays are kept between calls, so that reusing a push_relabel object
+// for many flow problems avoids reallocation.
 class push_relabel {
  public:
-    push_relabel() { }
+    push_relabel() : m_parallel_min_edges(PARALLEL_FLOW_MIN_EDGES) { }
     virtual ~push_relabel() { }
 
  private:
     void init(std::shared_ptr<mutable_graph> G,
-              std::vector<NodeID> sources,
-              NodeID source) {
-        m_Q = std::queue<NodeID>();
-        m_excess.clear();
-        m_distance.clear();
-        m_active.clear();
-        m_count.clear();
-        m_bfstouched.clear();
+              const std::vector<NodeID>& sources,
+              NodeID source,
+              const flow_snapshot* initial_flow) {
+        NodeID n = G->number_of_nodes();
+        m_G = G;
+        m_source = sources[source];
+        m_sources = sources;
+
+        // flows are stored in the solver and not in the graph, so that
+        // multiple flows can be computed on the same graph at once
+        m_flow_offset.resize(n + 1);
+        m_flow_offset[0] = 0;
+        for (NodeID v : G->nodes()) {
+            m_flow_offset[v + 1] =
+                m_flow_offset[v] + G->get_first_invalid_edge(v);
+        }
+        m_flow.assign(m_flow_offset.back(), 0);
+
+        m_excess.assign(n, 0);
+        m_distance.assign(n, 0);
+        m_current_edge.assign(n, 0);
+        m_is_sink.assign(n, false);
+        m_next_active.resize(n);
+        m_next.resize(n);
+        m_prev.resize(n);
+        m_bucket_active.assign(2 * n + 1, UNDEFINED_NODE);
+        m_bucket_all.assign(n + 1, UNDEFINED_NODE);
+        m_max_active = 0;
+        m_max_level = 0;
+        m_phase_one = true;
+
+        if (m_threads > 1) {
+            m_added_excess.assign(n, 0);
+            m_new_distance.resize(n);
+            m_in_next.assign(n, 0);
+            m_thread_active.resize(m_threads);
+        }
 
-        m_excess.resize(G->number_of_nodes(), 0);
-        m_distance.resize(G->number_of_nodes(), 0);
-        m_active.resize(G->number_of_nodes(), false);
-        m_count.resize(2 * G->number_of_nodes(), 0);
-        m_bfstouched.resize(G->number_of_nodes(), false);
-        m_already_contracted.resize(G->number_of_nodes(), false);
+        for (NodeID s : sources) {
+            if (s != m_source) {
+                m_is_sink[s] = true;
+            }
+        }
 
-        m_count[0] = G->number_of_nodes() - 1;
-        m_count[G->number_of_nodes()] = 1;
+        if (initial_flow) {
+            transferFlow(*initial_flow);
+        }
 
-        NodeID flow_source = sources[source];
+        m_distance[m_source] = n;
+        for (EdgeID e : G->edges_of(m_source)) {
+            FlowType capacity = G->getEdgeWeight(m_source, e);
+            FlowType residual_capacity = residual(m_source, e);
+            if (residual_capacity > 0) {
+                NodeID target = G->getEdgeTarget(m_source, e);
+                EdgeID rev_e = G->getReverseEdge(m_source, e);
+                setEdgeFlow(m_source, e, capacity);
+                setEdgeFlow(target, rev_e, -capacity);
+                m_excess[m_source] -= residual_capacity;
+                m_excess[target] += residual_capacity;
+            }
+        }
 
-        m_distance[flow_source] = G->number_of_nodes();
+        if (initial_flow) {
+            repairDeficits();
+        }
+    }
 
-        for (NodeID n : sources) {
-            m_active[n] = true;
+    // sets the flow of the snapshot on all edges that still exist. flows
+    // between vertices that were contracted cancel out, flows are clamped
+    // to the capacity of the edge.
+    void transferFlow(const flow_snapshot& snapshot) {
+        NodeID n = m_G->number_of_nodes();
+        // bucket the snapshot edges by their current tail
+        m_snapshot_offset.assign(n + 1, 0);
+        m_snapshot_order.resize(snapshot.edges.size());
+        for (const auto& [tail, head, flow] : snapshot.edges) {
+            m_snapshot_offset[m_G->getCurrentPosition(tail) + 1]++;
         }
+        for (NodeID v = 0; v < n; ++v) {
+            m_snapshot_offset[v + 1] += m_snapshot_offset[v];
+        }
+        m_snapshot_next.assign(m_snapshot_offset.begin(),
+                               m_snapshot_offset.end() - 1);
+        for (size_t i = 0; i < snapshot.edges.size(); ++i) {
+            NodeID v = m_G->getCurrentPosition(std::get<0>(snapshot.edges[i]));
+            m_snapshot_order[m_snapshot_next[v]++] = i;
+        }
+
+        // position of the edge to each neighbor of the current tail
+        m_edge_to.resize(n);
+        m_edge_to_tail.assign(n, UNDEFINED_NODE);
+        for (NodeID v : m_G->nodes()) {
+            if (m_snapshot_offset[v] == m_snapshot_offset[v + 1])
+                continue;
+
+            for (EdgeID e : m_G->edges_of(v)) {
+                NodeID target = m_G->getEdgeTarget(v, e);
+                m_edge_to[target] = e;
+                m_edge_to_tail[target] = v;
+            }
 
-        for (EdgeID e : G->edges_of(flow_source)) {
-            m_excess[flow_source] += G->getEdgeWeight(flow_source, e);
-            push(flow_source, e);
+            for (EdgeID i = m_snapshot_offset[v];
+                 i < m_snapshot_offset[v + 1]; ++i) {
+                const auto& edge = snapshot.edges[m_snapshot_order[i]];
+                NodeID w = m_G->getCurrentPosition(std::get<1>(edge));
+                if (w == v || m_edge_to_tail[w] != v)
+                    continue;
+
+                EdgeID e = m_edge_to[w];
+                EdgeID rev_e = m_G->getReverseEdge(v, e);
+                FlowType flow = getEdgeFlow(v, e) + std::get<2>(edge);
+                setEdgeFlow(v, e, flow);
+                setEdgeFlow(w, rev_e, -flow);
+            }
+        }
+
+        // clamping an edge also changes the flow of its reverse edge, so
+        // the excesses are only computed after all edges are clamped
+        for (NodeID v : m_G->nodes()) {
+            for (EdgeID e : m_G->edges_of(v)) {
+                FlowType capacity = m_G->getEdgeWeight(v, e);
+                if (getEdgeFlow(v, e) > capacity) {
+                    NodeID target = m_G->getEdgeTarget(v, e);
+                    setEdgeFlow(v, e, capacity);
+                    setEdgeFlow(target, m_G->getReverseEdge(v, e), -capacity);
+                }
+            }
+        }
+
+        for (NodeID v : m_G->nodes()) {
+            for (EdgeID e : m_G->edges_of(v)) {
+                m_excess[v] -= getEdgeFlow(v, e);
+            }
         }
     }
 
-    // perform a backward bfs in the residual starting at the sink
-    // to update distance labels
-    void global_relabeling(std::vector<NodeID> sources, NodeID source) {
-        std::queue<NodeID> Q;
-        NodeID flow_source = sources[source];
+    // removes negative excess from all vertices but the source by reducing
+    // their outgoing flow. this moves the deficit along the flow, until it
+    // reaches a vertex with enough excess.
+    void repairDeficits() {
+        m_bfs_queue.clear();
+        for (NodeID v : m_G->nodes()) {
+            if (v != m_source && m_excess[v] < 0) {
+                m_bfs_queue.emplace_back(v);
+            }
+        }
 
-        for (NodeID n : m_G->nodes()) {
-            m_bfstouched[n] = false;
-            m_distance[n] = std::max(m_distance[n], m_G->number_of_nodes());
+        for (size_t i = 0; i < m_bfs_queue.size(); ++i) {
+            NodeID v = m_bfs_queue[i];
+            for (EdgeID e : m_G->edges_of(v)) {
+                if (m_excess[v] >= 0)
+                    break;
+
+                FlowType flow = getEdgeFlow(v, e);
+                if (flow <= 0)
+                    continue;
+
+                NodeID target = m_G->getEdgeTarget(v, e);
+                FlowType amount = std::min(flow, -m_excess[v]);
+                setEdgeFlow(v, e, flow - amount);
+                setEdgeFlow(target, m_G->getReverseEdge(v, e), amount - flow);
+                m_excess[v] += amount;
+                bool had_deficit = m_excess[target] < 0;
+                m_excess[target] -= amount;
+                if (!had_deficit && m_excess[target] < 0
+                    && target != m_source) {
+                    m_bfs_queue.emplace_back(target);
+                }
+            }
         }
+    }
 
-        for (NodeID sink : sources) {
-            if (sink == flow_source)
-                continue;
+    bool isTerminal(NodeID v) const {
+        return m_is_sink[v] || v == m_source;
+    }
+
+    FlowType residual(NodeID v, EdgeID e) const {
+        return static_cast<FlowType>(m_G->getEdgeWeight(v, e))
+               - getEdgeFlow(v, e);
+    }
 
-            Q.push(sink);
-            m_bfstouched[sink] = true;
-            m_distance[sink] = 0;
+    void addActive(NodeID v) {
+        NodeID level = m_distance[v];
+        m_next_active[v] = m_bucket_active[level];
+        m_bucket_active[level] = v;
+        m_max_active = std::max(m_max_active, level);
+    }
+
+    void addToLevel(NodeID v) {
+        NodeID level = m_distance[v];
+        m_prev[v] = UNDEFINED_NODE;
+        m_next[v] = m_bucket_all[level];
+        if (m_bucket_all[level] != UNDEFINED_NODE) {
+            m_prev[m_bucket_all[level]] = v;
         }
+        m_bucket_all[level] = v;
+        m_max_level = std::max(m_max_level, level);
+    }
 
-        m_bfstouched[flow_source] = true;
+    void removeFromLevel(NodeID v) {
+        if (m_prev[v] == UNDEFINED_NODE) {
+            m_bucket_all[m_distance[v]] = m_next[v];
+        } else {
+            m_next[m_prev[v]] = m_next[v];
+        }
 
-        NodeID node = 0;
-        while (!Q.empty()) {
-            node = Q.front();
-            Q.pop();
+        if (m_next[v] != UNDEFINED_NODE) {
+            m_prev[m_next[v]] = m_prev[v];
+        }
+    }
+
+    // perform a backward bfs in the residual starting at the sinks
+    // to compute exact distance labels. vertices that can not reach
+    // a sink get label n and are not considered in the first phase.
+    void global_relabeling() {
+        NodeID n = m_G->number_of_nodes();
+        std::fill(m_bucket_active.begin(), m_bucket_active.begin() + n,
+                  UNDEFINED_NODE);
+        std::fill(m_bucket_all.begin(), m_bucket_all.end(), UNDEFINED_NODE);
+        m_max_active = 0;
+        m_max_level = 0;
+
+        m_bfs_queue.clear();
+        for (NodeID v : m_G->nodes()) {
+            if (m_is_sink[v]) {
+                m_distance[v] = 0;
+                m_bfs_queue.emplace_back(v);
+            } else {
+                m_distance[v] = n;
+            }
+        }
 
+        for (size_t i = 0; i < m_bfs_queue.size(); ++i) {
+            NodeID node = m_bfs_queue[i];
             for (EdgeID e : m_G->edges_of(node)) {
                 NodeID target = m_G->getEdgeTarget(node, e);
-                if (m_bfstouched[target]) continue;
+                if (m_distance[target] < n || isTerminal(target))
+                    continue;
 
                 EdgeID rev_e = m_G->getReverseEdge(node, e);
-                if (m_G->getEdgeWeight(target, rev_e) -
-                    getEdgeFlow(target, rev_e) > 0) {
-                    m_count[m_distance[target]]--;
+                if (residual(target, rev_e) > 0) {
                     m_distance[target] = m_distance[node] + 1;
-                    m_count[m_distance[target]]++;
-                    Q.push(target);
-                    m_bfstouched[target] = true;
+                    m_current_edge[target] = 0;
+                    m_bfs_queue.emplace_back(target);
+                    addToLevel(target);
+                    if (m_excess[target] > 0) {
+                        addActive(target);
+                    }
                 }
             }
         }
     }
 
-    // push flow from source to target if possible
-    void push(NodeID source, EdgeID e) {
+    // push flow over edge e of source if possible
+    void push(NodeID source, EdgeID e, NodeID target) {
         m_pushes++;
-        FlowType capacity = m_G->getEdgeWeight(source, e);
-        FlowType flow = getEdgeFlow(source, e);
-
-        FlowType amount = std::min(capacity - flow, m_excess[source]);
-        NodeID target = m_G->getEdgeTarget(source, e);
-
-        if (m_distance[source] <= m_distance[target] || amount == 0) return;
-
-        setEdgeFlow(source, e, flow + amount);
-
+        FlowType amount = std::min(residual(source, e), m_excess[source]);
         EdgeID rev_e = m_G->getReverseEdge(source, e);
-        FlowType rev_flow = getEdgeFlow(target, rev_e);
-        setEdgeFlow(target, rev_e, rev_flow - amount);
 
-        m_excess[source] -= amount;
-        m_excess[target] += amount;
+        setEdgeFlow(source, e, getEdgeFlow(source, e) + amount);
+        setEdgeFlow(target, rev_e, getEdgeFlow(target, rev_e) - amount);
 
-        enqueue(target);
-    }
-
-    // put a vertex in the FIFO queue of the global_mincut
-    void enqueue(NodeID target) {
-        if (m_active[target]) return;
-        if (m_excess[target] > 0) {
-            m_active[target] = true;
-            // m_Q.push(target, m_distance[target]);
-            m_Q.push(target);
+        m_excess[source] -= amount;
+        if (m_excess[target] == 0 && !isTerminal(target)) {
+            addActive(target);
         }
+        m_excess[target] += amount;
     }
 
     // try to push as much excess as possible out of the node node
     void discharge(NodeID node) {
-        for (EdgeID e : m_G->edges_of(node)) {
+        NodeID n = m_G->number_of_nodes();
+        while (m_excess[node] > 0) {
+            EdgeID end = m_G->get_first_invalid_edge(node);
+            EdgeID e = m_current_edge[node];
+            for ( ; e < end; ++e) {
+                NodeID target = m_G->getEdgeTarget(node, e);
+                if (m_distance[node] == m_distance[target] + 1
+                    && residual(node, e) > 0) {
+                    push(node, e, target);
+                    if (m_excess[node] == 0)
+                        break;
+                }
+            }
+            m_current_edge[node] = e;
+
             if (m_excess[node] == 0)
                 break;
 
-            push(node, e);
-        }
+            if (m_phase_one) {
+                NodeID level = m_distance[node];
+                if (m_bucket_all[level] == node
+                    && m_next[node] == UNDEFINED_NODE) {
+                    // hence this layer will be empty after the relabel step
+                    gap_heuristic(level);
+                    return;
+                }
+                removeFromLevel(node);
+            }
 
-        if (m_excess[node] > 0) {
-            if (m_count[m_distance[node]] == 1
-                && m_distance[node] < m_G->number_of_nodes()) {
-                // hence this layer will be empty after the relabel step
-                gap_heuristic(m_distance[node]);
-            } else {
-                relabel(node);
+            relabel(node);
+
+            if (!m_phase_one && m_distance[node] >= 2 * n) {
+                // excess can not be returned, only if the preflow is invalid
+                return;
+            }
+
+            if (m_phase_one) {
+                if (m_distance[node] >= n) {
+                    m_distance[node] = n;
+                    return;
+                }
+                addToLevel(node);
             }
         }
     }
 
-    // gap heuristic
+    // all vertices on level 'level' and above can not reach a sink anymore
     void gap_heuristic(NodeID level) {
         m_gaps++;
-        for (NodeID node : m_G->nodes()) {
-            if (m_distance[node] < level) continue;
-            m_count[m_distance[node]]--;
-            m_distance[node] = std::max(m_distance[node], m_G->n());
-            m_count[m_distance[node]]++;
-            enqueue(node);
+        NodeID n = m_G->number_of_nodes();
+        for (NodeID l = level; l <= m_max_level; ++l) {
+            for (NodeID v = m_bucket_all[l]; v != UNDEFINED_NODE;
+                 v = m_next[v]) {
+                m_distance[v] = n;
+            }
+            m_bucket_all[l] = UNDEFINED_NODE;
+            m_bucket_active[l] = UNDEFINED_NODE;
         }
+        m_max_level = level - 1;
     }
 
     // relabel a node with respect to its
@@ -184,20 +409,252 @@ class push_relabel {
         m_work += WORK_OP_RELABEL;
         m_num_relabels++;
 
-        m_count[m_distance[node]]--;
-        m_distance[node] = 2 * m_G->number_of_nodes();
-
+        NodeID new_distance = 2 * m_G->number_of_nodes();
         for (EdgeID e : m_G->edges_of(node)) {
-            if (m_G->getEdgeWeight(node, e) - getEdgeFlow(node, e) > 0) {
+            if (residual(node, e) > 0) {
                 NodeID target = m_G->getEdgeTarget(node, e);
-                m_distance[node] =
-                    std::min(m_distance[node], m_distance[target] + 1);
+                new_distance = std::min(new_distance, m_distance[target] + 1);
             }
             m_work++;
         }
 
-        m_count[m_distance[node]]++;
-        enqueue(node);
+        m_distance[node] = new_distance;
+        m_current_edge[node] = 0;
+    }
+
+    // processes active vertices in highest label order
+    void run(EdgeID work_todo) {
+        while (true) {
+            while (m_max_active > 0
+                   && m_bucket_active[m_max_active] == UNDEFINED_NODE) {
+                m_max_active--;
+            }
+
+            NodeID v = m_bucket_active[m_max_active];
+            if (v == UNDEFINED_NODE)
+                break;
+
+            m_bucket_active[m_max_active] = m_next_active[v];
+            discharge(v);
+
+            if (m_phase_one && m_work > GLOBAL_UPDATE_FRQ * work_todo) {
+                global_relabeling();
+                m_work = 0;
+                m_global_updates++;
+            }
+        }
+    }
+
+    // second phase: returns the excess of vertices that can not reach
+    // a sink back to the source. labels are distances to the source + n.
+    void return_excess(EdgeID work_todo) {
+        NodeID n = m_G->number_of_nodes();
+        m_phase_one = false;
+        std::fill(m_bucket_active.begin(), m_bucket_active.end(),
+                  UNDEFINED_NODE);
+        m_max_active = 0;
+
+        m_bfs_queue.clear();
+        for (NodeID v : m_G->nodes()) {
+            if (!m_is_sink[v]) {
+                m_distance[v] = 2 * n;
+            }
+        }
+        m_distance[m_source] = n;
+        m_bfs_queue.emplace_back(m_source);
+
+        for (size_t i = 0; i < m_bfs_queue.size(); ++i) {
+            NodeID node = m_bfs_queue[i];
+            for (EdgeID e : m_G->edges_of(node)) {
+                NodeID target = m_G->getEdgeTarget(node, e);
+                if (m_distance[target] < 2 * n || isTerminal(target))
+                    continue;
+
+                EdgeID rev_e = m_G->getReverseEdge(node, e);
+                if (residual(target, rev_e) > 0) {
+                    m_distance[target] = m_distance[node] + 1;
+                    m_current_edge[target] = 0;
+                    m_bfs_queue.emplace_back(target);
+                    if (m_excess[target] > 0) {
+                        addActive(target);
+                    }
+                }
+            }
+        }
+
+        run(work_todo);
+    }
+
+    // parallel bfs from the sinks, sets the same labels as global_relabeling
+    // and collects all active vertices with label < n in m_active
+    void parallel_global_relabeling() {
+        NodeID n = m_G->number_of_nodes();
+#pragma omp parallel for num_threads(m_threads) schedule(static)
+        for (NodeID v = 0; v < n; ++v) {
+            m_distance[v] = m_is_sink[v] ? 0 : n;
+            m_current_edge[v] = 0;
+        }
+
+        std::vector<NodeID> frontier;
+        for (NodeID v : m_G->nodes()) {
+            if (m_is_sink[v]) {
+                frontier.emplace_back(v);
+            }
+        }
+
+        m_active.clear();
+        while (!frontier.empty()) {
+#pragma omp parallel for num_threads(m_threads) schedule(dynamic, 64)
+            for (size_t i = 0; i < frontier.size(); ++i) {
+                NodeID node = frontier[i];
+                auto& next = m_thread_active[omp_get_thread_num()];
+                for (EdgeID e : m_G->edges_of(node)) {
+                    NodeID target = m_G->getEdgeTarget(node, e);
+                    if (m_distance[target] < n || isTerminal(target))
+                        continue;
+
+                    EdgeID rev_e = m_G->getReverseEdge(node, e);
+                    if (residual(target, rev_e) > 0
+                        && __sync_bool_compare_and_swap(
+                            &m_distance[target], n, m_distance[node] + 1)) {
+                        next.emplace_back(target);
+                    }
+                }
+            }
+
+            frontier.clear();
+            for (auto& next : m_thread_active) {
+                for (NodeID v : next) {
+                    frontier.emplace_back(v);
+                    if (m_excess[v] > 0) {
+                        m_active.emplace_back(v);
+                    }
+                }
+                next.clear();
+            }
+        }
+    }
+
+    // pushes the excess of an active vertex along admissible edges. as
+    // pushes only go to vertices one level lower, no edge is used by both
+    // of its vertices in the same round. received excess is collected in
+    // m_added_excess and only applied after the round.
+    EdgeID parallel_push(NodeID node, std::vector<NodeID>* next) {
+        FlowType excess = m_excess[node];
+        EdgeID end = m_G->get_first_invalid_edge(node);
+        EdgeID e = m_current_edge[node];
+        EdgeID work = 0;
+        for ( ; e < end; ++e) {
+            work++;
+            NodeID target = m_G->getEdgeTarget(node, e);
+            if (m_distance[node] != m_distance[target] + 1)
+                continue;
+
+            FlowType amount = std::min(residual(node, e), excess);
+            if (amount > 0) {
+                EdgeID rev_e = m_G->getReverseEdge(node, e);
+                setEdgeFlow(node, e, getEdgeFlow(node, e) + amount);
+                setEdgeFlow(target, rev_e,
+                            getEdgeFlow(target, rev_e) - amount);
+                excess -= amount;
+                __sync_fetch_and_add(&m_added_excess[target], amount);
+                if (!isTerminal(target) && !m_in_next[target]
+                    && __sync_bool_compare_and_swap(
+                        &m_in_next[target], 0, 1)) {
+                    next->emplace_back(target);
+                }
+                if (excess == 0)
+                    break;
+            }
+        }
+
+        m_current_edge[node] = e;
+        m_excess[node] = excess;
+        return work;
+    }
+
+    // first phase in synchronous parallel rounds
+    void parallel_run(EdgeID work_todo) {
+        NodeID n = m_G->number_of_nodes();
+        parallel_global_relabeling();
+
+        while (!m_active.empty()) {
+            EdgeID work = 0;
+#pragma omp parallel for num_threads(m_threads) schedule(dynamic, 64) \
+            reduction(+:work)
+            for (size_t i = 0; i < m_active.size(); ++i) {
+                work += parallel_push(
+                    m_active[i], &m_thread_active[omp_get_thread_num()]);
+            }
+
+            // relabels use the labels of the previous round, which keeps
+            // the labeling valid for the edges that became residual
+#pragma omp parallel for num_threads(m_threads) schedule(dynamic, 64) \
+            reduction(+:work)
+            for (size_t i = 0; i < m_active.size(); ++i) {
+                NodeID v = m_active[i];
+                if (m_excess[v] > 0) {
+                    NodeID new_distance = n;
+                    for (EdgeID e : m_G->edges_of(v)) {
+                        if (residual(v, e) > 0) {
+                            new_distance = std::min(
+                                new_distance, m_distance[m_G->getEdgeTarget(
+                                                  v, e)] + 1);
+                        }
+                    }
+                    m_new_distance[v] = new_distance;
+                    work += WORK_OP_RELABEL + m_G->get_first_invalid_edge(v);
+                }
+            }
+
+            std::vector<NodeID> remaining;
+            for (NodeID v : m_active) {
+                if (m_excess[v] > 0) {
+                    m_distance[v] = m_new_distance[v];
+                    m_current_edge[v] = 0;
+                    m_num_relabels++;
+                    if (m_distance[v] < n && !m_in_next[v]) {
+                        m_in_next[v] = 1;
+                        remaining.emplace_back(v);
+                    }
+                }
+            }
+
+            m_active.swap(remaining);
+            for (auto& next : m_thread_active) {
+                m_active.insert(m_active.end(), next.begin(), next.end());
+                next.clear();
+            }
+
+#pragma omp parallel for num_threads(m_threads) schedule(static)
+            for (size_t i = 0; i < m_active.size(); ++i) {
+                NodeID v = m_active[i];
+                m_excess[v] += m_added_excess[v];
+                m_added_excess[v] = 0;
+                m_in_next[v] = 0;
+            }
+
+            // excess pushed into terminals is not in any active list
+            for (NodeID s : m_sources) {
+                m_excess[s] += m_added_excess[s];
+                m_added_excess[s] = 0;
+            }
+
+            m_work += work;
+            if (m_work > GLOBAL_UPDATE_FRQ * work_todo) {
+                parallel_global_relabeling();
+                m_work = 0;
+                m_global_updates++;
+            } else {
+                remaining.clear();
+                for (NodeID v : m_active) {
+                    if (m_distance[v] < n) {
+                        remaining.emplace_back(v);
+                    }
+                }
+                m_active.swap(remaining);
+            }
+        }
     }
 
     std::vector<NodeID> computeSourceSet(const std::vector<NodeID>& sources,
@@ -207,9 +664,7 @@ class push_relabel {
         source_set.clear();
         NodeID src = sources[curr_source];
 
-        for (NodeID node : m_G->nodes()) {
-            m_bfstouched[node] = false;
-        }
+        m_bfstouched.assign(m_G->number_of_nodes(), false);
 
         std::queue<NodeID> Q;
         for (NodeID tgt : sources) {
@@ -228,8 +683,7 @@ class push_relabel {
                 EdgeID rev_e = m_G->getReverseEdge(node, e);
 
                 NodeID edge_source = m_G->getEdgeTarget(node, e);
-                FlowType resCap = m_G->getEdgeWeight(edge_source, rev_e)
-                                  - getEdgeFlow(edge_source, rev_e);
+                FlowType resCap = residual(edge_source, rev_e);
                 if (resCap > 0 && !m_bfstouched[edge_source]) {
                     Q.push(edge_source);
                     m_bfstouched[edge_source] = true;
@@ -259,40 +713,23 @@ class push_relabel {
     }
 
     void setEdgeFlow(NodeID n, EdgeID e, FlowType f) {
-        if (m_parallel_flows) {
-            edge_flow[n][e] = f;
-        } else {
-            m_G->setEdgeFlow(n, e, f);
-        }
-    }
-
-    FlowType getEdgeFlow(NodeID n, EdgeID e) {
-        if (m_parallel_flows) {
-            return edge_flow[n][e];
-        } else {
-            return m_G->getEdgeFlow(n, e);
-        }
+        m_flow[m_flow_offset[n] + e] = f;
     }
 
  public:
-    std::vector<NodeID> callable_max_flow(std::shared_ptr<mutable_graph> G,
-                                          std::vector<NodeID> sources,
-                                          NodeID curr_source,
-                                          bool compute_source_set) {
-        // this exists to be called by std::async.
-        // thus, parallel_flows is set to true
-        auto source_set = solve_max_flow_min_cut(
-            G, sources, curr_source, compute_source_set, true).second;
-
-        return source_set;
-    }
-
+    // maximum flow from sources[curr_source] to all other vertices in
+    // sources. if min_cut_only is set, only a maximum preflow is computed,
+    // which gives the same flow value and source set. the first phase uses
+    // up to num_threads threads if the graph is large enough. if
+    // initial_flow is given, the computation starts from that flow.
     std::pair<FlowType, std::vector<NodeID> > solve_max_flow_min_cut(
         std::shared_ptr<mutable_graph> G,
         std::vector<NodeID> sources,
         NodeID curr_source,
         bool compute_source_set,
-        bool parallel_flows = false) {
+        bool min_cut_only = false,
+        size_t num_threads = 1,
+        const flow_snapshot* initial_flow = nullptr) {
         for (NodeID s : sources) {
             if (s >= G->number_of_nodes()) {
                 LOG1 << "source " << s << " is too large (only "
@@ -301,59 +738,40 @@ class push_relabel {
             }
         }
 
-        if (parallel_flows) {
-            // if we have parallel flows on the same graphs,
-            // we can't use edge flows on the graph.
-            // in sequential cases it's faster and flow values
-            // might still be useful outside of this algorithm
-            edge_flow.clear();
-            for (NodeID n : G->nodes()) {
-                edge_flow.emplace_back(G->get_first_invalid_edge(n), 0);
-            }
-        } else {
-            for (NodeID n : G->nodes()) {
-                for (EdgeID e : G->edges_of(n)) {
-                    G->setEdgeFlow(n, e, 0);
-                }
-            }
-        }
-
-        m_parallel_flows = parallel_flows;
-        m_G = G;
         m_work = 0;
         m_num_relabels = 0;
         m_gaps = 0;
         m_pushes = 0;
         m_global_updates = 1;
-        NodeID src = sources[curr_source];
 
-        init(G, sources, curr_source);
-        global_relabeling(sources, curr_source);
+        m_threads = 1;
+        if (num_threads > 1 && G->number_of_edges() >= m_parallel_min_edges) {
+            m_threads = num_threads;
+        }
 
-        int work_todo = WORK_NODE_TO_EDGES * G->number_of_nodes()
-                        + G->number_of_edges();
-        // main loop
-        while (!m_Q.empty()) {
-            NodeID v = m_Q.front();
-            m_Q.pop();
-            m_active[v] = false;
-            discharge(v);
+        init(G, sources, curr_source, initial_flow);
 
-            if (m_work > GLOBAL_UPDATE_FRQ * work_todo) {
-                global_relabeling(sources, curr_source);
-                m_work = 0;
-                m_global_updates++;
-            }
+        EdgeID work_todo = WORK_NODE_TO_EDGES * G->number_of_nodes()
+                           + G->number_of_edges();
+        if (m_threads > 1) {
+            parallel_run(work_todo);
+        } else {
+            global_relabeling();
+            run(work_todo);
         }
 
         FlowType total_flow = 0;
         // return value of flow
         for (NodeID n : sources) {
-            if (n != src) {
+            if (n != m_source) {
                 total_flow += m_excess[n];
             }
         }
 
+        if (!min_cut_only) {
+            return_excess(work_todo);
+        }
+
         std::vector<NodeID> source_set;
 
         if (compute_source_set) {
@@ -362,25 +780,83 @@ class push_relabel {
 
         LOGC(extended_logs) << "updates " << m_global_updates
                             << " relabel " << m_num_relabels
+                            << " gaps " << m_gaps
                             << " pushes " << m_pushes;
         return std::make_pair(total_flow, source_set);
     }
 
+    // snapshot of the last computed flow (or preflow), can be used as
+    // initial flow after the graph was modified
+    std::shared_ptr<flow_snapshot> saveFlow() const {
+        auto snapshot = std::make_shared<flow_snapshot>();
+        for (NodeID v : m_G->nodes()) {
+            for (EdgeID e : m_G->edges_of(v)) {
+                FlowType flow = getEdgeFlow(v, e);
+                if (flow > 0) {
+                    NodeID target = m_G->getEdgeTarget(v, e);
+                    snapshot->edges.emplace_back(
+                        m_G->containedVertex(v),
+                        m_G->containedVertex(target), flow);
+                }
+            }
+        }
+        return snapshot;
+    }
+
+    // minimum number of edges for which the parallel solver is used
+    void setParallelMinEdges(EdgeID min_edges) {
+        m_parallel_min_edges = min_edges;
+    }
+
+    // flow on edge e of vertex n in the last computed flow
+    // (or preflow, if min_cut_only was set)
+    FlowType getEdgeFlow(NodeID n, EdgeID e) const {
+        return m_flow[m_flow_offset[n] + e];
+    }
+
  private:
     std::vector<FlowType> m_excess;
     std::vector<NodeID> m_distance;
-    std::vector<bool> m_active;   // store which nodes are in the queue already
-    std::vector<int> m_count;
-    std::queue<NodeID> m_Q;
+    std::vector<EdgeID> m_current_edge;
+    std::vector<bool> m_is_sink;
     std::vector<bool> m_bfstouched;
-    std::vector<bool> m_already_contracted;
-    std::vector<std::vector<FlowType> > edge_flow;
+    std::vector<NodeID> m_bfs_queue;
+    // active vertices per label, singly linked
+    std::vector<NodeID> m_bucket_active;
+    std::vector<NodeID> m_next_active;
+    // all vertices with label < n per label, doubly linked
+    std::vector<NodeID> m_bucket_all;
+    std::vector<NodeID> m_next;
+    std::vector<NodeID> m_prev;
+    NodeID m_max_active;
+    NodeID m_max_level;
+    bool m_phase_one;
+
+    // parallel first phase
+    size_t m_threads;
+    EdgeID m_parallel_min_edges;
+    std::vector<NodeID> m_sources;
+    std::vector<NodeID> m_active;
+    std::vector<std::vector<NodeID> > m_thread_active;
+    std::vector<FlowType> m_added_excess;
+    std::vector<NodeID> m_new_distance;
+    std::vector<uint8_t> m_in_next;
+
+    // warm start
+    std::vector<EdgeID> m_snapshot_offset;
+    std::vector<EdgeID> m_snapshot_next;
+    std::vector<size_t> m_snapshot_order;
+    std::vector<EdgeID> m_edge_to;
+    std::vector<NodeID> m_edge_to_tail;
+
+    std::vector<FlowType> m_flow;
+    std::vector<EdgeID> m_flow_offset;
+    NodeID m_source;
     int m_num_relabels;
     int m_gaps;
     int m_global_updates;
     int m_pushes;
-    int m_work;
+    EdgeID m_work;
     std::shared_ptr<mutable_graph> m_G;
     static const bool extended_logs = false;
-    bool m_parallel_flows;
 };
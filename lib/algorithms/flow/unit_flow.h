@@ -29,19 +29,20 @@ class unit_flow {
     unit_flow() { }
     virtual ~unit_flow() { }
 
-    void init(flow_graph fg, const std::vector<EdgeWeight>& delta_src,
+    // flow is computed on 'fg', which needs to outlive the computation
+    void init(flow_graph* fg, const std::vector<EdgeWeight>& delta_src,
               EdgeWeight unit_cap, NodeID max_height, FlowType w) {
-        m_f.resize(fg.number_of_nodes());
-        m_fg = &fg;
+        m_f.resize(fg->number_of_nodes());
+        m_fg = fg;
         m_delta_src = delta_src;
         m_unit_cap = unit_cap;
         m_max_height = max_height;
         m_w = w;
-        m_current_edge.resize(fg.number_of_nodes(), 0);
-        m_height.resize(fg.number_of_nodes(), 0);
-        for (NodeID n = 0; n < fg.number_of_nodes(); ++n) {
+        m_current_edge.resize(fg->number_of_nodes(), 0);
+        m_height.resize(fg->number_of_nodes(), 0);
+        for (NodeID n = 0; n < fg->number_of_nodes(); ++n) {
             m_f[n] = delta_src[n];
-            if (delta_src[n] > (EdgeWeight)fg.getCapacity(n)) {
+            if (delta_src[n] > (EdgeWeight)fg->getCapacity(n)) {
                 LOG << "Inserting" << n;
                 Q.push(std::make_pair(0, n));
             }
@@ -11,6 +11,8 @@
 
 #pragma once
 
+#include <omp.h>
+
 #include <algorithm>
 #include <map>
 #include <memory>
@@ -271,16 +273,18 @@ class recursive_cactus {
         }
 
         VIECUT_ASSERT_TRUE(isCNCR(G));
-        FlowType max_flow;
-
         auto [s, e, tgt] = findFlowEdge(G);
 
-        {
-            std::vector<NodeID> vtcs = { s, tgt };
-            push_relabel pr;
-            max_flow = pr.solve_max_flow_min_cut(
-                G, vtcs, 0, false, false).first;
-        }
+        std::vector<NodeID> vtcs = { s, tgt };
+#ifdef PARALLEL
+        // flows on the large graphs of the first recursion levels use all
+        // threads, the solver falls back to sequential on small graphs
+        size_t flow_threads = omp_get_max_threads();
+#else
+        size_t flow_threads = 1;
+#endif
+        FlowType max_flow = flow_solver.solve_max_flow_min_cut(
+            G, vtcs, 0, false, false, flow_threads).first;
 
         if (max_flow > (FlowType)mincut) {
             LOG << "max flow is larger " << max_flow;
@@ -300,7 +304,10 @@ class recursive_cactus {
             }
             // contract
             strongly_connected_components scc;
-            auto [v, num_comp] = scc.strong_components(G);
+            auto [v, num_comp] = scc.strong_components(
+                G, [this](NodeID n, EdgeID edge) {
+                    return flow_solver.getEdgeFlow(n, edge);
+                });
 
             if (num_comp == 2
                 && (G->getWeightedNodeDegree(s) == mincut
@@ -777,4 +784,6 @@ class recursive_cactus {
 
     timer t;
     EdgeWeight mincut;
+    // workspace of the flow computations on all recursion levels
+    push_relabel flow_solver;
 };
@@ -0,0 +1,204 @@
+/******************************************************************************
+ * connected_components.h
+ *
+ * Source of VieCut
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/configuration.h"
+#include "common/definitions.h"
+#include "data_structure/graph_access.h"
+#include "data_structure/mutable_graph.h"
+#include "tlx/logger.hpp"
+#include "tools/graph_extractor.h"
+#include "tools/vector.h"
+
+// Parallel connected components of undirected graphs using the
+// Afforest algorithm of Sutton et al. (https://arxiv.org/abs/1805.08856):
+// link the first few neighbors of every vertex, find the largest
+// intermediate component by sampling and only process the remaining
+// neighborhood of vertices that are not in it.
+//
+// The parent array is linked with CAS the same way as in
+// parallel/data_structure/union_find.h. That header can not be used here, as
+// it shares its class name with the sequential union_find that the multicut
+// code includes in the same translation units.
+class connected_components {
+ public:
+    static constexpr bool debug = false;
+
+    connected_components() { }
+    virtual ~connected_components() { }
+
+    std::pair<std::vector<int>, size_t> find_components(
+        std::shared_ptr<mutable_graph> G) {
+        afforest(G->number_of_nodes(),
+                 [&G](NodeID n) { return G->get_first_invalid_edge(n); },
+                 [&G](NodeID n, EdgeID e) {
+                     return G->getEdgeTarget(n, e);
+                 });
+
+        std::vector<int> comp_num(G->number_of_nodes());
+        size_t num_comp = relabel(&comp_num);
+        return std::make_pair(comp_num, num_comp);
+    }
+
+    size_t find_components(std::shared_ptr<graph_access> G,
+                           std::vector<int>* cn) {
+        afforest(G->number_of_nodes(),
+                 [&G](NodeID n) { return G->getNodeDegree(n); },
+                 [&G](NodeID n, EdgeID e) {
+                     return G->getEdgeTarget(G->get_first_edge(n) + e);
+                 });
+
+        cn->resize(G->number_of_nodes());
+        return relabel(cn);
+    }
+
+    std::shared_ptr<graph_access> largest_cc(std::shared_ptr<graph_access> G) {
+        std::vector<int> components(G->number_of_nodes());
+        size_t ct = find_components(G, &components);
+        LOG << "count of connected components: " << ct;
+
+        std::vector<uint64_t> compsizes(ct, 0);
+        for (int component : components) {
+            ++compsizes[component];
+        }
+
+        auto max_size = std::max_element(compsizes.begin(), compsizes.end());
+        int max_comp = static_cast<int>(max_size - compsizes.begin());
+
+#pragma omp parallel for schedule(static)
+        for (NodeID n = 0; n < G->number_of_nodes(); ++n) {
+            G->setPartitionIndex(n, components[n] == max_comp ? 0 : 1);
+        }
+
+        graph_extractor ge;
+        return ge.extract_block(G, 0).first;
+    }
+
+ private:
+    // number of neighbors of each vertex that are linked before sampling
+    static constexpr EdgeID neighbor_rounds = 2;
+    static constexpr size_t num_samples = 1024;
+
+    template <typename DegreeFunction, typename TargetFunction>
+    void afforest(NodeID n, DegreeFunction degree, TargetFunction target) {
+        m_parent.resize(n);
+
+#pragma omp parallel for schedule(static)
+        for (NodeID v = 0; v < n; ++v) {
+            m_parent[v] = v;
+        }
+
+        for (EdgeID r = 0; r < neighbor_rounds; ++r) {
+#pragma omp parallel for schedule(dynamic, 16384)
+            for (NodeID v = 0; v < n; ++v) {
+                if (degree(v) > r) {
+                    link(v, target(v, r));
+                }
+            }
+            compress();
+        }
+
+        NodeID largest = sampleLargestComponent();
+
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (NodeID v = 0; v < n; ++v) {
+            if (m_parent[v] == largest)
+                continue;
+
+            EdgeID deg = degree(v);
+            for (EdgeID e = neighbor_rounds; e < deg; ++e) {
+                link(v, target(v, e));
+            }
+        }
+        compress();
+    }
+
+    // hook the tree with the higher root below the tree with the lower root
+    void link(NodeID u, NodeID v) {
+        NodeID p1 = m_parent[u];
+        NodeID p2 = m_parent[v];
+
+        while (p1 != p2) {
+            NodeID high = std::max(p1, p2);
+            NodeID low = std::min(p1, p2);
+            NodeID p_high = m_parent[high];
+
+            if (p_high == low)
+                break;
+
+            if (p_high == high
+                && __sync_bool_compare_and_swap(&m_parent[high], high, low))
+                break;
+
+            p1 = m_parent[m_parent[high]];
+            p2 = m_parent[low];
+        }
+    }
+
+    void compress() {
+#pragma omp parallel for schedule(dynamic, 16384)
+        for (NodeID v = 0; v < m_parent.size(); ++v) {
+            while (m_parent[v] != m_parent[m_parent[v]]) {
+                m_parent[v] = m_parent[m_parent[v]];
+            }
+        }
+    }
+
+    NodeID sampleLargestComponent() {
+        if (m_parent.empty())
+            return UNDEFINED_NODE;
+
+        std::mt19937 mt(configuration::getConfig()->seed);
+        std::uniform_int_distribution<NodeID> dist(0, m_parent.size() - 1);
+        std::unordered_map<NodeID, size_t> count;
+
+        for (size_t i = 0; i < num_samples; ++i) {
+            ++count[m_parent[dist(mt)]];
+        }
+
+        return std::max_element(count.begin(), count.end(),
+                                [](const auto& a, const auto& b) {
+                                    return a.second < b.second;
+                                })->first;
+    }
+
+    // renumber components to 0..k-1 in order of their root vertex
+    size_t relabel(std::vector<int>* cn) {
+        std::vector<int>& comp_num = *cn;
+        std::vector<NodeID> root_id(m_parent.size());
+
+#pragma omp parallel for schedule(static)
+        for (NodeID v = 0; v < m_parent.size(); ++v) {
+            root_id[v] = (m_parent[v] == v) ? 1 : 0;
+        }
+
+        size_t num_comp = vector::prefix_sum(&root_id);
+
+#pragma omp parallel for schedule(static)
+        for (NodeID v = 0; v < m_parent.size(); ++v) {
+            comp_num[v] = static_cast<int>(root_id[m_parent[v]]);
+        }
+
+        return num_comp;
+    }
+
+    std::vector<NodeID> m_parent;
+};
@@ -15,7 +15,7 @@
 #include <memory>
 #include <vector>
 
-#include "algorithms/misc/strongly_connected_components.h"
+#include "algorithms/misc/connected_components.h"
 #include "common/definitions.h"
 #include "data_structure/graph_access.h"
 
@@ -137,9 +137,7 @@ class core_decomposition {
             exit(1);
         }
 
-        std::vector<int> components(core_graph->number_of_nodes());
-        strongly_connected_components scc;
-
-        return scc.largest_scc(core_graph);
+        connected_components cc;
+        return cc.largest_cc(core_graph);
     }
 };
@@ -29,8 +29,12 @@ class strongly_connected_components {
     strongly_connected_components() { }
     virtual ~strongly_connected_components() { }
 
+    // strongly connected components of the residual graph of a flow on G.
+    // flow(n, e) is the flow on edge e of vertex n, edges with
+    // flow equal to their weight are not in the residual graph.
+    template <typename FlowFunction>
     std::pair<std::vector<int>, size_t> strong_components(
-        std::shared_ptr<mutable_graph> G) {
+        std::shared_ptr<mutable_graph> G, FlowFunction flow) {
         m_dfsnum.resize(G->number_of_nodes());
         m_comp_num.resize(G->number_of_nodes());
         m_dfscount = 0;
@@ -43,7 +47,7 @@ class strongly_connected_components {
 
         for (NodeID node : G->nodes()) {
             if (m_dfsnum[node] == -1) {
-                explicit_scc_dfs(node, G);
+                explicit_scc_dfs(node, G, flow);
             }
         }
 
@@ -77,7 +81,9 @@ class strongly_connected_components {
         return m_comp_count;
     }
 
-    void explicit_scc_dfs(NodeID node, std::shared_ptr<mutable_graph> G) {
+    template <typename FlowFunction>
+    void explicit_scc_dfs(NodeID node, std::shared_ptr<mutable_graph> G,
+                          FlowFunction flow) {
         iteration_stack.push(
             std::pair<NodeID, EdgeID>(node, G->get_first_edge(node)));
 
@@ -93,7 +99,7 @@ class strongly_connected_components {
 
             for (EdgeID e : G->edges_of_starting_at(current_node,
                                                     current_edge)) {
-                if (G->getEdgeFlow(current_node, e)
+                if (flow(current_node, e)
                     == static_cast<FlowType>(
                         G->getEdgeWeight(current_node, e))) {
                     // edges that have full flow do not exist in residual graph
@@ -11,12 +11,16 @@
 
 #pragma once
 
+#include <omp.h>
+
 #include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <cstdio>
-#include <future>
+#include <deque>
+#include <fstream>
+#include <functional>
 #include <iterator>
 #include <limits>
 #include <memory>
@@ -24,23 +28,30 @@
 #include <queue>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
+#include "algorithms/flow/isolating_cuts.h"
 #include "algorithms/flow/push_relabel.h"
 #include "algorithms/global_mincut/noi_minimum_cut.h"
+#include "algorithms/misc/connected_components.h"
 #include "algorithms/misc/graph_algorithms.h"
+#include "algorithms/multicut/component_group.h"
 #include "algorithms/multicut/edge_selection.h"
 #include "algorithms/multicut/graph_contraction.h"
 #include "algorithms/multicut/kernelization_criteria.h"
+#include "algorithms/multicut/multicut_heuristic.h"
 #include "algorithms/multicut/multicut_problem.h"
-#include "algorithms/multicut/problem_queues/per_thread_problem_queue.h"
-#include "algorithms/multicut/problem_queues/single_problem_queue.h"
+#include "algorithms/multicut/problem_queues/disk_problem_queue.h"
+#include "algorithms/multicut/problem_queues/work_stealing_problem_queue.h"
+#include "algorithms/multicut/transposition_table.h"
 #include "coarsening/contract_graph.h"
 #include "common/configuration.h"
 #include "data_structure/union_find.h"
 #include "gperftools/malloc_extension.h"
 #include "io/graph_io.h"
 #include "tlx/math/div_ceil.hpp"
+#include "tools/graph_extractor.h"
 #include "tools/timer.h"
 #include "tools/vector.h"
 
@@ -58,31 +69,53 @@ class branch_multicut {
           global_upper_bound(std::numeric_limits<FlowType>::max()),
           problems(configuration::getConfig()->threads,
                    configuration::getConfig()->queue_type),
+          spilled_problems(configuration::getConfig()->spill_path),
+          memory_budget(configuration::getConfig()->memory_budget
+                        * 1024UL * 1024UL * 1024UL),
           total_time(),
           q_cv(configuration::getConfig()->threads),
           q_mutex(configuration::getConfig()->threads),
           num_threads(configuration::getConfig()->threads),
           branch_invalid(configuration::getConfig()->threads, 0),
+          flow_solvers(configuration::getConfig()->threads),
+          isolating_cut_solvers(configuration::getConfig()->threads),
+          num_flow_tasks(0),
           kc(configuration::getConfig()->contraction_type, original_terminals),
-          log_timer(0) { }
+          transpositions(configuration::getConfig()->transposition_log_size),
+          num_groups(0),
+          root_heuristic(false),
+          heuristic_offered(false),
+          next_heuristic(0),
+          heuristic_runs(0),
+          log_timer(0),
+          checkpoint_requested(false),
+          stop_after_checkpoint(false),
+          timed_out(false),
+          paused_threads(0),
+          checkpoint_round(0),
+          last_checkpoint(0),
+          checkpoint_component(0),
+          checkpoint_flow(0) { }
 
     ~branch_multicut() { }
 
-    size_t find_multiterminal_cut(std::shared_ptr<multicut_problem> mcp) {
-        best_solution.resize(original_graph.number_of_nodes());
-        auto cfg = configuration::getConfig();
-        problems.addProblem(mcp, 0);
-        std::vector<std::thread> threads;
+    // if resume is set, the search continues from the checkpoint file and
+    // mcp is ignored. if the time limit is reached, the search stops and
+    // the return value is not a valid multicut weight, see timedOut()
+    size_t find_multiterminal_cut(std::shared_ptr<multicut_problem> mcp,
+                                  bool resume = false) {
         is_finished = false;
         idle_threads = 0;
+        if (resume) {
+            readCheckpoint(configuration::getConfig()->checkpoint_file);
+        } else {
+            // solved by thread 0 before it is pinned, see pollWork
+            root_problem = mcp;
+        }
+        std::vector<std::thread> threads;
         for (size_t i = 0; i < num_threads; ++i) {
             threads.emplace_back(
                 std::thread(&branch_multicut::pollWork, this, i));
-            cpu_set_t cpuset;
-            CPU_ZERO(&cpuset);
-            CPU_SET(i, &cpuset);
-            pthread_setaffinity_np(threads[i].native_handle(),
-                                   sizeof(cpu_set_t), &cpuset);
         }
 
         for (auto& t : threads) {
@@ -91,31 +124,204 @@ class branch_multicut {
             }
             t.join();
         }
+
+        if (timed_out) {
+            return 0;
+        }
+
+        best_solution = bestSolution();
         FlowType total_weight = flowValue(false, best_solution);
 
+        if (transpositions.enabled()) {
+            size_t lookups = transpositions.numLookups();
+            size_t hits = transpositions.numHits();
+            LOG1 << "Transposition table: " << lookups << " lookups, "
+                 << hits << " hits, " << transpositions.numDuplicates()
+                 << " duplicates pruned, hit rate "
+                 << (lookups ? static_cast<double>(hits) / lookups : 0.0);
+        }
+
         VIECUT_ASSERT_EQ(total_weight, global_upper_bound);
 
         return (EdgeWeight)total_weight;
     }
 
+    // whether the last search stopped at the time limit. if a checkpoint
+    // file is set, the search state was written to it before stopping
+    bool timedOut() const {
+        return timed_out;
+    }
+
+    // number of problems that were spilled to disk and reloaded from it
+    size_t numSpilled() const {
+        return spilled_problems.written();
+    }
+
+    size_t numReloaded() const {
+        return spilled_problems.reloaded();
+    }
+
+    // checkpoints store the index of the connected component that is solved
+    // and the multicut weight of the components before it
+    void setCheckpointInfo(size_t component, FlowType previous_flow) {
+        checkpoint_component = component;
+        checkpoint_flow = previous_flow;
+    }
+
+    // component and weight of previous components stored in a checkpoint
+    static std::pair<size_t, FlowType> readCheckpointInfo(
+        const std::string& filename) {
+        std::ifstream f(filename.c_str(), std::ios::binary);
+        if (!f || disk_problem_queue::read<uint64_t>(&f) != checkpoint_magic) {
+            LOG1 << "Error: " << filename << " is not a checkpoint";
+            exit(1);
+        }
+        size_t component = disk_problem_queue::read<size_t>(&f);
+        FlowType flow = disk_problem_queue::read<FlowType>(&f);
+        return std::make_pair(component, flow);
+    }
+
+    // assignment of the original vertices to terminals in the best solution
+    // found so far. can be called while the algorithm is running
+    std::vector<NodeID> bestSolution() {
+        std::vector<NodeID> solution(original_graph.number_of_nodes(), 0);
+        bestsol_mutex.lock();
+        std::shared_ptr<solution_handle> best = best_handle;
+        bestsol_mutex.unlock();
+
+        if (best) {
+#pragma omp parallel for schedule(static)
+            for (NodeID n = 0; n < solution.size(); ++n) {
+                solution[n] = best->block(n);
+            }
+        }
+        return solution;
+    }
+
  private:
+    // problems with a lower bound of at least this value can not improve
+    // the best solution
+    FlowType upperBound(const std::shared_ptr<multicut_problem>& problem) {
+        if (problem->group) {
+            return problem->group->upperBound(problem->component,
+                                              global_upper_bound);
+        }
+        return global_upper_bound;
+    }
+
+    // the bounds of components of split problems are shifted by their
+    // offset, so equal graphs are only duplicates in the same component
+    uint64_t groupSalt(const std::shared_ptr<multicut_problem>& problem) {
+        if (problem->group) {
+            return transposition_table::mix(problem->group->id)
+                   + problem->component;
+        }
+        return 0;
+    }
+
+    // only the value and a handle to the problem are updated under the
+    // mutex, the solution itself is materialized in bestSolution(). the
+    // solution of a component is composed with the other components of
+    // its split problem, once all of them have a solution
+    void updateBestSolution(std::shared_ptr<multicut_problem> problem,
+                            FlowType value, bool leaf) {
+        if (value >= upperBound(problem))
+            return;
+
+        auto handle = std::make_shared<solution_handle>();
+        if (leaf) {
+            handle->problem = problem;
+        } else {
+            auto G = problem->graph;
+            handle->mappings = problem->mappings;
+            handle->blocks.resize(G->getOriginalNodes());
+            for (NodeID i = 0; i < G->getOriginalNodes(); ++i) {
+                handle->blocks[i] =
+                    G->getPartitionIndex(G->getCurrentPosition(i));
+            }
+        }
+
+        std::shared_ptr<component_group> group = problem->group;
+        size_t component = problem->component;
+        while (group) {
+            handle = group->addSolution(component, &value, handle);
+            if (!handle)
+                return;
+            component = group->parent_component;
+            group = group->parent;
+        }
+
+        bestsol_mutex.lock();
+        // check again inside mutex as global_upper_bound might have changed
+        if (value < global_upper_bound) {
+            global_upper_bound = value;
+            best_handle = handle;
+            LOGC(testing) << "Improvement after time="
+                          << total_time.elapsed() << " upper_bound=" << value;
+            LOGC(testing) << problem->path;
+        }
+        bestsol_mutex.unlock();
+    }
+
     bool queueNotEmpty(size_t thread_id) {
-        return !problems.empty(thread_id) || is_finished;
+        return !problems.empty(thread_id) || num_flow_tasks > 0
+               || !spilled_problems.empty() || checkpoint_requested
+               || heuristic_offered || is_finished;
     }
 
+    // wakes the sleeping threads, so they can steal a new problem
+    void notifyIdle() {
+        if (idle_threads > 0) {
+            for (size_t j = 0; j < num_threads; ++j) {
+                q_cv[j].notify_all();
+            }
+        }
+    }
+
+    // thread 0 first solves the root problem without being pinned, so it
+    // can kernelize it with all cores. the other threads are already
+    // pinned and steal its isolating flows.
     void pollWork(size_t thread_id) {
+        if (thread_id == 0 && root_problem) {
+            solveProblem(root_problem, 0, num_threads);
+            root_problem = nullptr;
+        }
+
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(thread_id, &cpuset);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+        // this thread is pinned to a single core, parallel regions in the
+        // graph operations would only start more threads on it
+        omp_set_num_threads(1);
         bool im_idle = false;
         while (!is_finished) {
+            if (checkpoint_requested) {
+                pauseForCheckpoint();
+                continue;
+            }
+
+            std::shared_ptr<multicut_problem> mcp;
             if (!problems.empty(thread_id)) {
-                std::shared_ptr<multicut_problem> mcp =
-                    problems.pullProblem(thread_id);
+                mcp = problems.pullProblem(thread_id);
+            }
+            if (!mcp) {
+                // no work in memory left, reload spilled problems
+                mcp = spilled_problems.pullProblem();
+            }
+            if (mcp) {
                 solveProblem(mcp, thread_id);
+            } else if (runFlowTask(thread_id)) {
+                // helped with the flows of a problem of another thread
+            } else if (runHeuristicTask()) {
+                // searched a better solution of an open problem
             } else {
                 if (!im_idle) {
                     idle_threads++;
                     im_idle = true;
                 }
-                if (idle_threads == num_threads && problems.all_empty()) {
+                if (idle_threads == num_threads && problems.all_empty()
+                    && spilled_problems.empty()) {
                     is_finished = true;
                     for (size_t j = 0; j < num_threads; ++j) {
                         q_cv[j].notify_all();
@@ -136,25 +342,34 @@ class branch_multicut {
         }
     }
 
+    // num_cores is the number of cores the calling thread can use. it is
+    // only larger than 1 for the root problem, which is solved before
+    // thread 0 is pinned. the isolating flows of a problem are run as tasks
+    // that the other threads steal, so they use a single core each
     void solveProblem(std::shared_ptr<multicut_problem> current_problem,
-                      size_t thread_id) {
-        if (current_problem->lower_bound >= global_upper_bound)
+                      size_t thread_id, size_t num_cores = 1) {
+        if (current_problem->lower_bound >= upperBound(current_problem)) {
+            current_problem->releaseSharedData();
             return;
+        }
 
-        uint64_t heapsize;
-        MallocExtension::instance()->GetNumericProperty(
-            "generic.heap_size", &heapsize);
+        spillProblems(thread_id);
 
-        uint64_t max_size = 250UL * 1024UL * 1024UL * 1024UL;
-        if (heapsize > max_size) {
-            LOG1 << "RESULT Memoryout";
-            exit(1);
+        auto cfg = configuration::getConfig();
+        if (total_time.elapsed() > cfg->time_limit) {
+            if (cfg->checkpoint_file.empty()) {
+                stopSearch();
+                return;
+            }
+            stop_after_checkpoint = true;
+            requestCheckpoint();
+        } else if (!cfg->checkpoint_file.empty()
+                   && total_time.elapsed()
+                   > last_checkpoint + cfg->checkpoint_interval) {
+            requestCheckpoint();
         }
 
-        if (total_time.elapsed() > 3600) {
-            LOG1 << "RESULT Timeout!";
-            exit(1);
-        }
+        materialize(current_problem);
 
         if (total_time.elapsed() > log_timer) {
             double logs_per_second = 2.0;
@@ -186,41 +401,56 @@ class branch_multicut {
                     current_problem->graph->getCurrentPosition(i));
             }
 
-            current_problem->mappings.emplace_back(map);
+            current_problem->addMapping(map);
             current_problem->graph = current_problem->graph->simplify();
+            if (current_problem->zobrist) {
+                current_problem->zobrist = transposition_table::simplifyKeys(
+                    *current_problem->zobrist, *map,
+                    current_problem->graph->getOriginalNodes());
+            }
+            // flows and candidates are stored by the original vertices of
+            // the old graph
+            current_problem->flows.clear();
+            current_problem->candidates.reset();
         }
 
         graph_contraction::setTerminals(current_problem, original_terminals);
+
+        // a problem with the same graph and at most the same deleted weight
+        // was already solved or is currently solved
+        transposition_table::key state {};
+        EdgeWeight deleted_before = current_problem->deleted_weight;
+        if (transpositions.enabled()) {
+            state = transposition_table::stateKey(
+                current_problem.get(), groupSalt(current_problem));
+            FlowType graph_lower;
+            if (transpositions.visit(state, deleted_before, &graph_lower))
+                return;
+            current_problem->lower_bound =
+                std::max(current_problem->lower_bound,
+                         static_cast<FlowType>(deleted_before) + graph_lower);
+            if (current_problem->lower_bound >= upperBound(current_problem))
+                return;
+        }
+
         NodeID edges_before = current_problem->graph->m();
 
         if (current_problem->terminals.size() == 2) {
             FlowType max =
-                maximumFlow(current_problem) + current_problem->deleted_weight;
-
-            if (max < global_upper_bound) {
-                bestsol_mutex.lock();
-                if (max < global_upper_bound) {
-                    LOGC(testing) << "Improvement after time="
-                                  << total_time.elapsed() << " upper_bound="
-                                  << current_problem->upper_bound;
-                    LOGC(testing) << current_problem->path;
-
-                    global_upper_bound = max;
-                    for (NodeID n = 0; n < best_solution.size(); ++n) {
-                        NodeID n_coarse = current_problem->mapped(n);
-                        auto t = current_problem->graph->getCurrentPosition(
-                            n_coarse);
-                        best_solution[n] =
-                            current_problem->graph->getPartitionIndex(t);
-                    }
-                }
-                bestsol_mutex.unlock();
-            }
+                maximumFlow(current_problem, thread_id, num_cores)
+                + current_problem->deleted_weight;
+
+            updateBestSolution(current_problem, max, true);
             if (configuration::getConfig()->noBranching) {
                 LOG1 << "ALREADY NOT-DELETED-2 " << global_upper_bound;
             }
         } else {
-            nonBranchingContraction(current_problem, thread_id);
+            nonBranchingContraction(current_problem, thread_id, num_cores);
+            if (transpositions.enabled()) {
+                transpositions.setLowerBound(
+                    state, current_problem->lower_bound - deleted_before);
+            }
+            primalHeuristic(current_problem);
             if (current_problem->graph->m() >= edges_before) {
                 if (configuration::getConfig()->noBranching) {
                     writeGraph(current_problem);
@@ -229,10 +459,10 @@ class branch_multicut {
                     branchOnEdge(current_problem, thread_id);
                 }
             } else {
-                if (current_problem->lower_bound < global_upper_bound) {
-                    size_t thr =
-                        problems.addProblem(current_problem, thread_id);
-                    q_cv[thr].notify_all();
+                if (current_problem->lower_bound
+                    < upperBound(current_problem)) {
+                    problems.addProblem(current_problem, thread_id);
+                    notifyIdle();
                 } else {
                     if (configuration::getConfig()->noBranching) {
                         LOG1 << "ALREADY NOT-DELETED-BOUND "
@@ -247,6 +477,163 @@ class branch_multicut {
         }
     }
 
+    // stops all threads at the time limit
+    void stopSearch() {
+        timed_out = true;
+        is_finished = true;
+        for (size_t j = 0; j < num_threads; ++j) {
+            q_cv[j].notify_all();
+        }
+    }
+
+    void requestCheckpoint() {
+        bool expected = false;
+        if (checkpoint_requested.compare_exchange_strong(expected, true)) {
+            for (size_t j = 0; j < num_threads; ++j) {
+                q_cv[j].notify_all();
+            }
+        }
+    }
+
+    // all threads stop between two problems, so every open problem is in
+    // a queue. the last thread to arrive writes the checkpoint.
+    void pauseForCheckpoint() {
+        std::unique_lock<std::mutex> lck(checkpoint_mutex);
+        if (++paused_threads == num_threads) {
+            writeCheckpoint(configuration::getConfig()->checkpoint_file);
+            if (stop_after_checkpoint) {
+                // all open problems are in the checkpoint, so the queues
+                // are empty and the other threads stop after waking up
+                stopSearch();
+            }
+            paused_threads = 0;
+            last_checkpoint = total_time.elapsed();
+            checkpoint_requested = false;
+            checkpoint_round++;
+            checkpoint_cv.notify_all();
+        } else {
+            // wait for the end of this round, a new checkpoint might
+            // already be requested when this thread wakes up
+            size_t round = checkpoint_round;
+            checkpoint_cv.wait(lck, [this, round] {
+                                   return checkpoint_round != round;
+                               });
+        }
+    }
+
+    // writes upper bound, best solution and all open problems. the file is
+    // replaced atomically, so a crash while writing keeps the old one
+    void writeCheckpoint(const std::string& filename) {
+        typedef disk_problem_queue dpq;
+        std::vector<std::pair<std::shared_ptr<multicut_problem>, size_t> >
+        open_problems;
+        for (size_t i = 0; i < num_threads; ++i) {
+            while (auto p = problems.pullWorstProblem(i)) {
+                if (p->lower_bound < global_upper_bound) {
+                    open_problems.emplace_back(p, i);
+                }
+            }
+        }
+
+        std::string tmp = filename + ".tmp";
+        std::ofstream f(tmp.c_str(), std::ios::binary);
+        if (!f) {
+            LOG1 << "Error opening checkpoint file " << tmp;
+            exit(1);
+        }
+        dpq::write(&f, checkpoint_magic);
+        dpq::write(&f, checkpoint_component);
+        dpq::write(&f, checkpoint_flow);
+        dpq::write(&f, original_graph.number_of_nodes());
+        dpq::write(&f, original_terminals.size());
+        dpq::write(&f, static_cast<FlowType>(global_upper_bound));
+
+        bool has_solution = (best_handle != nullptr);
+        dpq::write(&f, has_solution);
+        if (has_solution) {
+            std::vector<NodeID> solution = bestSolution();
+            f.write(reinterpret_cast<const char*>(solution.data()),
+                    solution.size() * sizeof(NodeID));
+        }
+
+        dpq::write(&f, open_problems.size() + spilled_problems.size());
+        for (const auto& [p, i] : open_problems) {
+            dpq::writeProblem(&f, p);
+        }
+        spilled_problems.copyProblems(&f);
+        f.close();
+        std::rename(tmp.c_str(), filename.c_str());
+
+        for (const auto& [p, i] : open_problems) {
+            problems.addProblem(p, i);
+        }
+        LOG1 << "Checkpoint with " << open_problems.size()
+             << " problems in memory and " << spilled_problems.size()
+             << " on disk after time=" << total_time.elapsed();
+    }
+
+    void readCheckpoint(const std::string& filename) {
+        typedef disk_problem_queue dpq;
+        std::ifstream f(filename.c_str(), std::ios::binary);
+        if (!f || dpq::read<uint64_t>(&f) != checkpoint_magic) {
+            LOG1 << "Error: " << filename << " is not a checkpoint";
+            exit(1);
+        }
+        dpq::read<size_t>(&f);
+        dpq::read<FlowType>(&f);
+        NodeID n = dpq::read<NodeID>(&f);
+        size_t k = dpq::read<size_t>(&f);
+        if (n != original_graph.number_of_nodes()
+            || k != original_terminals.size()) {
+            LOG1 << "Error: checkpoint " << filename
+                 << " belongs to a different instance";
+            exit(1);
+        }
+        global_upper_bound = dpq::read<FlowType>(&f);
+
+        if (dpq::read<bool>(&f)) {
+            best_handle = std::make_shared<solution_handle>();
+            best_handle->blocks.resize(n);
+            f.read(reinterpret_cast<char*>(best_handle->blocks.data()),
+                   n * sizeof(NodeID));
+        }
+
+        size_t num_problems = dpq::read<size_t>(&f);
+        for (size_t i = 0; i < num_problems; ++i) {
+            problems.addProblem(dpq::readProblem(&f), i % num_threads);
+        }
+        LOG1 << "Resumed from checkpoint with " << num_problems
+             << " problems and upper bound " << global_upper_bound;
+    }
+
+    uint64_t allocatedBytes() {
+        size_t allocated = 0;
+        if (!MallocExtension::instance()->GetNumericProperty(
+                "generic.current_allocated_bytes", &allocated)) {
+            return 0;
+        }
+        return allocated;
+    }
+
+    // while the memory budget is exceeded, the problems with the lowest
+    // priority in the queue of this thread are written to disk. pending
+    // modifications are written with the graph, so a shared graph is not
+    // copied while we are already over budget. flow snapshots are not
+    // written, spilled problems compute their flows from scratch
+    void spillProblems(size_t thread_id) {
+        while (allocatedBytes() > memory_budget) {
+            auto problem = problems.pullWorstProblem(thread_id);
+            if (!problem)
+                return;
+
+            if (problem->lower_bound < upperBound(problem)) {
+                spilled_problems.addProblem(problem);
+            }
+            // the problem is reloaded with its own graph
+            problem->releaseSharedData();
+        }
+    }
+
     void writeGraph(std::shared_ptr<multicut_problem> problem) {
         std::string outgraph =
             configuration::getConfig()->graph_filename
@@ -334,48 +721,40 @@ class branch_multicut {
             current_problem, original_terminals);
 
         if (!current_problem->graph->number_of_edges()) {
-            if (static_cast<FlowType>(current_problem->deleted_weight)
-                < global_upper_bound) {
-                bestsol_mutex.lock();
-                if (static_cast<FlowType>(current_problem->deleted_weight)
-                    < global_upper_bound) {
-                    global_upper_bound =
-                        std::min(static_cast<FlowType>(
-                                     current_problem->deleted_weight),
-                                 global_upper_bound);
-                    LOGC(testing) << "noedges - Improvement after time="
-                                  << total_time.elapsed() << " upper_bound="
-                                  << current_problem->upper_bound;
-                    LOGC(testing) << current_problem->path;
-
-                    for (NodeID n = 0; n < best_solution.size(); ++n) {
-                        NodeID n_coarse = current_problem->mapped(n);
-                        auto t = current_problem->graph->getCurrentPosition(
-                            n_coarse);
-                        best_solution[n] =
-                            current_problem->graph->getPartitionIndex(t);
-                    }
-                }
-                bestsol_mutex.unlock();
-            }
+            updateBestSolution(
+                current_problem,
+                static_cast<FlowType>(current_problem->deleted_weight), true);
             return;
         }
 
+        if (splitComponents(current_problem, thread_id))
+            return;
+
         auto [branch_vtx, branch_edge] =
             findEdge(current_problem, edge_selection);
 
+        // both children update the hash of this graph in materialize
+        if (transpositions.enabled()
+            && !transposition_table::hasGraphHash(*current_problem)) {
+            transposition_table::hashGraph(current_problem.get());
+        }
+
         size_t max_wgt =
             current_problem->graph->getEdgeWeight(branch_vtx, branch_edge);
+        FlowType upper_bound = upperBound(current_problem);
         // |-> edge in multicut
         if (max_wgt + current_problem->deleted_weight
-            < (EdgeWeight)global_upper_bound) {
+            < (EdgeWeight)upper_bound) {
             // ^- if this is not true, there can not be a better cut
             // where the deleted edge is in the optimal multicut
+            //
+            // the graph is shared with the contraction branch below and
+            // only copied when the problem is pulled from the queue
             auto delete_problem = std::make_shared<multicut_problem>();
 
-            delete_problem->graph = std::make_shared<mutable_graph>(
-                *current_problem->graph);
-            delete_problem->graph->deleteEdge(branch_vtx, branch_edge);
+            delete_problem->graph = current_problem->graph;
+            delete_problem->delta.emplace_back(
+                graph_delta::delete_edge, branch_vtx, branch_edge);
             delete_problem->terminals = current_problem->terminals;
 
             for (auto& t : delete_problem->terminals) {
@@ -385,6 +764,16 @@ class branch_multicut {
             }
 
             delete_problem->mappings = current_problem->mappings;
+            delete_problem->flows = current_problem->flows;
+            delete_problem->group = current_problem->group;
+            delete_problem->component = current_problem->component;
+            delete_problem->zobrist = current_problem->zobrist;
+            delete_problem->vertex_keys = current_problem->vertex_keys;
+            delete_problem->graph_hash = current_problem->graph_hash;
+            delete_problem->graph_weight = current_problem->graph_weight;
+            delete_problem->hashed_edges = current_problem->hashed_edges;
+            // only loses the branch edge, so the candidates stay valid
+            delete_problem->candidates = current_problem->candidates;
             delete_problem->lower_bound = current_problem->lower_bound;
             delete_problem->deleted_weight =
                 current_problem->deleted_weight + max_wgt;
@@ -393,14 +782,21 @@ class branch_multicut {
             delete_problem->upper_bound =
                 current_problem->upper_bound + max_wgt;
 
-            if (delete_problem->lower_bound < global_upper_bound) {
-                size_t thr = problems.addProblem(delete_problem, thread_id);
-                q_cv[thr].notify_all();
+            if (delete_problem->lower_bound < upper_bound) {
+                auto token = std::make_shared<branch_token>();
+                delete_problem->branch = token;
+                current_problem->branch = token;
+                trimFlows(delete_problem);
+                problems.addProblem(delete_problem, thread_id);
+                notifyIdle();
             }
         }
 
         // |-> edge not in multicut
-        current_problem->graph->contractEdge(branch_vtx, branch_edge);
+        // contraction and deletion of edges between terminals
+        // are performed in materialize()
+        current_problem->delta.emplace_back(
+            graph_delta::contract_edge, branch_vtx, branch_edge);
 
         for (auto& t : current_problem->terminals) {
             if (t.position == branch_vtx) {
@@ -408,42 +804,104 @@ class branch_multicut {
             }
         }
 
-        graph_contraction::deleteEdgesBetweenTerminals(current_problem,
-                                                       original_terminals);
-
-        if (current_problem->lower_bound < global_upper_bound) {
-            size_t thr = problems.addProblem(current_problem, thread_id);
-            q_cv[thr].notify_all();
+        if (current_problem->lower_bound < upper_bound) {
+            trimFlows(current_problem);
+            problems.addProblem(current_problem, thread_id);
+            notifyIdle();
         }
     }
 
-    void nonBranchingContraction(std::shared_ptr<multicut_problem> mcp,
-                                 size_t thread_id) {
-        FlowType contracting_flow = maximumIsolatingFlow(mcp, thread_id);
-        if (mcp->upper_bound < global_upper_bound) {
-            bestsol_mutex.lock();
-            // check again inside mutex as global_upper_bound might have changed
-            if (mcp->upper_bound < global_upper_bound) {
-                global_upper_bound = mcp->upper_bound;
-
-                for (NodeID n = 0; n < best_solution.size(); ++n) {
-                    NodeID n_coarse = mcp->mapped(n);
-                    auto t = mcp->graph->getCurrentPosition(n_coarse);
-                    best_solution[n] = mcp->graph->getPartitionIndex(t);
-                }
+    // applies the pending modifications of a problem. both problems created
+    // in branchOnEdge share the graph and vertex keys of their parent, the
+    // one materialized first works on copies and the second one can modify
+    // them in place, see branch_token. the same holds for the candidates.
+    // afterwards, the problem is the only one using them.
+    void materialize(std::shared_ptr<multicut_problem> problem) {
+        if (problem->delta.empty())
+            return;
+
+        // the graph hash and the branching candidates of the parent are
+        // updated with the delta, so they do not need to be recomputed
+        bool hashed = problem->delta.size() == 1
+                      && transposition_table::hasGraphHash(*problem);
+        if (!hashed) {
+            problem->vertex_keys.reset();
+        }
+        if (problem->candidates
+            && (problem->delta.size() > 1
+                || problem->candidates->num_nodes != problem->graph->n())) {
+            problem->candidates.reset();
+        }
 
-                global_upper_bound = flowValue(false, best_solution);
-                LOGC(testing) << "Improvement after time="
-                              << total_time.elapsed() << " upper_bound="
-                              << global_upper_bound;
+        if (!problem->ownsSharedData()) {
+            problem->graph = std::make_shared<mutable_graph>(*problem->graph);
+            if (problem->vertex_keys) {
+                problem->vertex_keys = std::make_shared<std::vector<uint64_t> >(
+                    *problem->vertex_keys);
+            }
+            if (problem->candidates) {
+                problem->candidates =
+                    std::make_shared<edge_candidates>(*problem->candidates);
+            }
+        }
+        problem->releaseSharedData();
+
+        bool contracted = false;
+        NodeID kept = 0;
+        for (const graph_delta& d : problem->delta) {
+            if (d.op == graph_delta::contract_edge) {
+                if (hashed) {
+                    transposition_table::removeEndpoints(problem.get(),
+                                                         d.vertex, d.edge);
+                }
+                auto G = problem->graph;
+                // contractEdge keeps the endpoint with the lower id
+                kept = std::min(d.vertex, G->getEdgeTarget(d.vertex, d.edge));
+                NodeID removed = G->contractEdge(d.vertex, d.edge);
+                if (hashed) {
+                    transposition_table::mergeEndpoints(problem.get(),
+                                                        kept, removed);
+                }
+                contracted = true;
+            } else {
+                if (hashed) {
+                    transposition_table::deleteEdge(problem.get(),
+                                                    d.vertex, d.edge);
+                }
+                problem->graph->deleteEdge(d.vertex, d.edge);
             }
-            bestsol_mutex.unlock();
         }
-        kc.perform_kernelization(mcp, global_upper_bound, contracting_flow);
+        problem->delta.clear();
+
+        if (contracted) {
+            // the branch graph had no edges between terminals, so only
+            // edges of the contracted vertex are deleted here
+            graph_contraction::deleteEdgesBetweenTerminals(
+                problem, original_terminals);
+            if (hashed) {
+                transposition_table::addVertex(problem.get(), kept);
+            }
+            if (problem->candidates) {
+                problem->candidates->contracted(problem, kept);
+            }
+        }
+    }
+
+    void nonBranchingContraction(std::shared_ptr<multicut_problem> mcp,
+                                 size_t thread_id, size_t num_cores) {
+        FlowType contracting_flow = maximumIsolatingFlow(mcp, thread_id,
+                                                         num_cores);
+        // the problem is still worked on, so its partition is copied
+        updateBestSolution(mcp, mcp->upper_bound, false);
+        kc.perform_kernelization(mcp, upperBound(mcp), contracting_flow,
+                                 num_cores);
     }
 
-    FlowType maximumFlow(std::shared_ptr<multicut_problem> problem) {
-        push_relabel pr;
+    // flows on graphs with at least PARALLEL_FLOW_MIN_EDGES edges use the
+    // parallel push-relabel with num_cores threads
+    FlowType maximumFlow(std::shared_ptr<multicut_problem> problem,
+                         size_t thread_id, size_t num_cores) {
+        push_relabel& pr = flow_solvers[thread_id];
         auto G = problem->graph;
 
         std::vector<NodeID> current_terminals;
@@ -451,8 +909,9 @@ class branch_multicut {
             current_terminals.emplace_back(t.position);
         }
 
-        auto [flow, isolating_block] =
-            pr.solve_max_flow_min_cut(G, current_terminals, 0, true);
+        auto [flow, isolating_block] = pr.solve_max_flow_min_cut(
+            G, current_terminals, 0, true, true, num_cores,
+            warmStartFlow(problem, 0));
 
         NodeID term0 = problem->terminals[0].original_id;
         NodeID term1 = problem->terminals[1].original_id;
@@ -474,72 +933,163 @@ class branch_multicut {
         return flow;
     }
 
-    FlowType maximumIsolatingFlow(std::shared_ptr<multicut_problem> problem,
-                                  size_t thread_id) {
-        graph_contraction::setTerminals(problem, original_terminals);
-        std::vector<FlowType> isolating_flow;
-        std::vector<std::vector<NodeID> > maxVolIsoBlock;
-        std::vector<NodeID> curr_terminals;
-        std::vector<NodeID> orig_index;
+    // flow of the last computation for terminal i in an ancestor of the
+    // problem, if there is one
+    const flow_snapshot* warmStartFlow(
+        std::shared_ptr<multicut_problem> problem, NodeID i) {
+        NodeID orig_id = problem->terminals[i].original_id;
+        if (orig_id < problem->flows.size()) {
+            return problem->flows[orig_id].get();
+        }
+        return nullptr;
+    }
+
+    // a queued problem only keeps the snapshots of the flows it recomputes,
+    // so it holds at most one per terminal with invalid flow. they are part
+    // of the allocated bytes checked against the memory budget, above it
+    // queued problems keep none
+    void trimFlows(std::shared_ptr<multicut_problem> problem) {
+        if (problem->flows.empty())
+            return;
+
+        if (allocatedBytes() > memory_budget) {
+            problem->flows.clear();
+            return;
+        }
+
+        std::vector<std::shared_ptr<flow_snapshot> > kept(
+            problem->flows.size());
         for (const auto& t : problem->terminals) {
-            curr_terminals.emplace_back(t.position);
-            orig_index.emplace_back(t.original_id);
+            if (t.invalid_flow) {
+                kept[t.original_id] = problem->flows[t.original_id];
+            }
         }
+        problem->flows.swap(kept);
+    }
 
-        bool parallel_flows = false;
-        std::vector<std::future<std::vector<NodeID> > > futures;
-        // so futures don't lose their object :)
-        std::vector<push_relabel> prs(problem->terminals.size());
-        if (problems.size() == 0) {
-            // in the beginning when we don't have many problems
-            // already (but big graphs), we can start a thread per flow.
-            // later on, we have a problem for each processor to work on,
-            // so we run sequential flows
-            parallel_flows = true;
+    // runs a flow task of another thread, returns false if there is none
+    bool runFlowTask(size_t thread_id) {
+        if (num_flow_tasks == 0)
+            return false;
+
+        std::function<void(size_t)> task;
+        {
+            std::lock_guard<std::mutex> lck(flow_task_mutex);
+            if (flow_tasks.empty())
+                return false;
+            task = std::move(flow_tasks.front());
+            flow_tasks.pop_front();
+            num_flow_tasks--;
         }
+        task(thread_id);
+        return true;
+    }
 
-        for (NodeID i = 0; i < problem->terminals.size(); ++i) {
-            if (problem->terminals[i].invalid_flow) {
-                if (parallel_flows) {
-                    maxVolIsoBlock.emplace_back();
-                    cpu_set_t all_cores;
-                    CPU_ZERO(&all_cores);
-                    for (size_t i = 0; i < num_threads; ++i) {
-                        CPU_SET(i, &all_cores);
-                    }
+    // adds the flows of a problem as tasks that idle threads can steal and
+    // works on tasks until none is left, then waits until the tasks taken
+    // by other threads are finished. the task gets the id of the thread
+    // that runs it, so it can use that thread's workspace.
+    void runFlowTasks(std::vector<std::function<void(size_t)> >* tasks,
+                      size_t thread_id) {
+        size_t remaining = tasks->size();
+        std::mutex done_mutex;
+        std::condition_variable done_cv;
+        {
+            std::lock_guard<std::mutex> lck(flow_task_mutex);
+            for (auto& task : *tasks) {
+                flow_tasks.emplace_back(
+                    [&remaining, &done_mutex, &done_cv, task](size_t t) {
+                        task(t);
+                        std::lock_guard<std::mutex> done_lck(done_mutex);
+                        if (--remaining == 0) {
+                            done_cv.notify_all();
+                        }
+                    });
+            }
+            num_flow_tasks += tasks->size();
+        }
 
-                    sched_setaffinity(0, sizeof(cpu_set_t), &all_cores);
-                    futures.emplace_back(
-                        std::async(&push_relabel::callable_max_flow,
-                                   &prs[i],
-                                   problem->graph, curr_terminals, i, true));
-                } else {
-                    push_relabel pr;
-                    maxVolIsoBlock.emplace_back(
-                        pr.solve_max_flow_min_cut(problem->graph,
-                                                  curr_terminals,
-                                                  i,
-                                                  true).second);
-                }
+        if (tasks->size() > 1) {
+            for (size_t j = 0; j < num_threads; ++j) {
+                q_cv[j].notify_all();
+            }
+        }
 
+        while (runFlowTask(thread_id)) { }
+
+        std::unique_lock<std::mutex> lck(done_mutex);
+        done_cv.wait(lck, [&remaining] { return remaining == 0; });
+    }
+
+    // one flow for each terminal with invalid flow, the other terminals
+    // are already contracted with their isolating cut. every flow is a task
+    // on a single core, idle threads run them in parallel
+    std::vector<std::vector<NodeID> > isolatingFlows(
+        std::shared_ptr<multicut_problem> problem,
+        size_t thread_id,
+        const std::vector<NodeID>& curr_terminals,
+        const std::vector<NodeID>& orig_index) {
+        std::vector<std::vector<NodeID> > maxVolIsoBlock(
+            problem->terminals.size());
+        std::vector<std::function<void(size_t)> > tasks;
+
+        problem->flows.resize(original_terminals.size());
+        for (NodeID i = 0; i < problem->terminals.size(); ++i) {
+            if (problem->terminals[i].invalid_flow) {
+                tasks.emplace_back(
+                    [this, problem, &curr_terminals, &orig_index,
+                     &maxVolIsoBlock, i](size_t t) {
+                        push_relabel& pr = flow_solvers[t];
+                        maxVolIsoBlock[i] =
+                            pr.solve_max_flow_min_cut(
+                                problem->graph, curr_terminals, i, true,
+                                true, 1,
+                                warmStartFlow(problem, i)).second;
+                        problem->flows[orig_index[i]] = pr.saveFlow();
+                    });
                 problem->terminals[i].invalid_flow = false;
             } else {
-                maxVolIsoBlock.emplace_back();
-                maxVolIsoBlock.back().emplace_back(
+                maxVolIsoBlock[i].emplace_back(
                     problem->terminals[i].position);
             }
         }
 
-        if (parallel_flows) {
-            for (size_t i = 0; i < futures.size(); ++i) {
-                auto& t = futures[i];
-                maxVolIsoBlock[i] = t.get();
-            }
+        runFlowTasks(&tasks, thread_id);
+        return maxVolIsoBlock;
+    }
+
+    // isolating cuts of all terminals with O(log k) flows
+    std::vector<std::vector<NodeID> > allIsolatingCuts(
+        std::shared_ptr<multicut_problem> problem,
+        size_t thread_id, size_t num_cores,
+        const std::vector<NodeID>& curr_terminals) {
+        auto cuts = isolating_cut_solvers[thread_id].computeIsolatingCuts(
+            problem->graph, curr_terminals, num_cores);
 
-            cpu_set_t my_id;
-            CPU_ZERO(&my_id);
-            CPU_SET(thread_id, &my_id);
-            sched_setaffinity(0, sizeof(cpu_set_t), &my_id);
+        for (auto& t : problem->terminals) {
+            t.invalid_flow = false;
+        }
+        return cuts;
+    }
+
+    FlowType maximumIsolatingFlow(std::shared_ptr<multicut_problem> problem,
+                                  size_t thread_id, size_t num_cores = 1) {
+        graph_contraction::setTerminals(problem, original_terminals);
+        std::vector<FlowType> isolating_flow;
+        std::vector<std::vector<NodeID> > maxVolIsoBlock;
+        std::vector<NodeID> curr_terminals;
+        std::vector<NodeID> orig_index;
+        for (const auto& t : problem->terminals) {
+            curr_terminals.emplace_back(t.position);
+            orig_index.emplace_back(t.original_id);
+        }
+
+        if (configuration::getConfig()->use_isolating_cuts) {
+            maxVolIsoBlock = allIsolatingCuts(problem, thread_id, num_cores,
+                                              curr_terminals);
+        } else {
+            maxVolIsoBlock = isolatingFlows(problem, thread_id,
+                                            curr_terminals, orig_index);
         }
 
         graph_contraction::contractIsolatingBlocks(problem, maxVolIsoBlock);
@@ -584,7 +1134,6 @@ class branch_multicut {
         problem->upper_bound = problem->deleted_weight + sum - maximum;
         problem->lower_bound = problem->deleted_weight + tlx::div_ceil(sum, 2);
 
-        // findSubproblems(problem);
         if (debug) {
             graph_algorithms::checkGraphValidity(problem->graph);
         }
@@ -592,65 +1141,249 @@ class branch_multicut {
         return contr_flow;
     }
 
-    void findSubproblems(std::shared_ptr<multicut_problem> problem) {
-        std::queue<NodeID> block;
-        std::vector<bool> checked(problem->graph->number_of_nodes(), false);
-        std::vector<bool> terminal(problem->graph->number_of_nodes(), false);
-        NodeID n = 0;
+    // splits a problem whose graph has several connected components with at
+    // least two terminals into one problem for each of these components.
+    // returns false if the problem was not split. component groups only
+    // exist in memory and are not part of checkpoints, so problems are
+    // never split if a checkpoint file is set
+    bool splitComponents(std::shared_ptr<multicut_problem> problem,
+                         size_t thread_id) {
+        if (!configuration::getConfig()->checkpoint_file.empty())
+            return false;
 
-        for (const auto& m : problem->terminals) {
-            checked[m.position] = true;
-            terminal[m.position] = true;
+        auto G = problem->graph;
+        NodeID n = G->number_of_nodes();
+        connected_components cc;
+        auto [component, num_comp] = cc.find_components(G);
+        std::vector<NodeID> component_size(num_comp, 0);
+        for (NodeID v = 0; v < n; ++v) {
+            component_size[component[v]]++;
         }
 
-        while (n < problem->graph->number_of_nodes()) {
-            while (checked[n]) {
-                n++;
+        std::vector<NodeID> num_terminals(num_comp, 0);
+        std::vector<NodeID> terminal_block(num_comp, 0);
+        for (size_t l = 0; l < original_terminals.size(); ++l) {
+            NodeID v = G->getCurrentPosition(
+                problem->mapped(original_terminals[l]));
+            num_terminals[component[v]]++;
+            terminal_block[component[v]] = l;
+        }
+
+        // index of the components with at least two terminals. a single
+        // vertex with several terminals contains the other components of a
+        // split problem and is not part of its solution
+        std::vector<NodeID> index(num_comp, UNDEFINED_NODE);
+        std::vector<NodeID> split;
+        for (NodeID c = 0; c < num_comp; ++c) {
+            if (num_terminals[c] > 1 && component_size[c] > 1) {
+                index[c] = split.size();
+                split.emplace_back(c);
             }
+        }
+
+        if (split.size() < 2)
+            return false;
+
+        auto layout = std::make_shared<component_layout>();
+        layout->mappings = problem->mappings;
+        layout->component.resize(G->getOriginalNodes());
+        layout->block.resize(G->getOriginalNodes());
+        for (NodeID u = 0; u < G->getOriginalNodes(); ++u) {
+            NodeID c = component[G->getCurrentPosition(u)];
+            layout->component[u] = index[c];
+            layout->block[u] = terminal_block[c];
+        }
 
-            if (n >= problem->graph->number_of_nodes()) {
-                break;
+        auto group = std::make_shared<component_group>(
+            problem->group, problem->component, problem->deleted_weight,
+            split.size(), ++num_groups);
+        group->layout = layout;
+
+        // all parts are extracted in a single pass. the vertices outside of
+        // a part are mapped to an extra vertex without edges
+        NodeID num_split = split.size();
+        std::vector<NodeID> block_of(n);
+        for (NodeID v = 0; v < n; ++v) {
+            NodeID i = index[component[v]];
+            block_of[v] = (i == UNDEFINED_NODE) ? num_split : i;
+        }
+        std::vector<bool> extract(num_split + 1, true);
+        extract[num_split] = false;
+        graph_extractor ge;
+        auto [graphs, new_id] =
+            ge.extract_blocks(G, block_of, num_split + 1, extract, 1);
+
+        // zobrist keys of the vertices of each part, the extra vertex of a
+        // part gets the keys of all vertices outside of it
+        std::vector<std::vector<uint64_t> > part_keys;
+        uint64_t total_key = 0;
+        if (problem->zobrist) {
+            part_keys.resize(num_split + 1);
+            for (NodeID i = 0; i < num_split; ++i) {
+                part_keys[i].resize(graphs[i]->n(), 0);
+            }
+            for (NodeID u = 0; u < G->getOriginalNodes(); ++u) {
+                NodeID v = G->getCurrentPosition(u);
+                uint64_t key = (*problem->zobrist)[u];
+                if (block_of[v] < num_split) {
+                    part_keys[block_of[v]][new_id[v]] += key;
+                }
+                total_key += key;
             }
+        }
 
-            std::vector<bool> t_this(problem->graph->number_of_nodes(), false);
-            size_t terms = 0;
-            size_t vtcs = 1;
+        std::vector<std::shared_ptr<multicut_problem> > parts;
+        FlowType lower_sum = 0;
+        for (NodeID i = 0; i < num_split; ++i) {
+            auto part = std::make_shared<multicut_problem>();
+            part->graph = graphs[i];
+            NodeID extra = part->graph->n() - 1;
+            // every original vertex has to be mapped to a vertex of the part
+            auto map = std::make_shared<std::vector<NodeID> >(
+                G->getOriginalNodes());
+            for (NodeID u = 0; u < G->getOriginalNodes(); ++u) {
+                NodeID v = G->getCurrentPosition(u);
+                (*map)[u] = (block_of[v] == i) ? new_id[v] : extra;
+            }
+            part->mappings = problem->mappings;
+            part->addMapping(map);
 
-            block.emplace(n);
-            checked[n++] = true;
+            if (problem->zobrist) {
+                uint64_t part_key = 0;
+                for (uint64_t key : part_keys[i]) {
+                    part_key += key;
+                }
+                part_keys[i][extra] = total_key - part_key;
+                part->zobrist = std::make_shared<std::vector<uint64_t> >(
+                    std::move(part_keys[i]));
+            }
 
-            while (!block.empty()) {
-                NodeID node = block.front();
-                block.pop();
+            part->deleted_weight = problem->deleted_weight;
+            part->path = problem->path;
+            part->group = group;
+            part->component = i;
+            maximumIsolatingFlow(part, thread_id);
+            lower_sum += part->lower_bound - problem->deleted_weight;
+            parts.emplace_back(part);
+        }
 
-                for (EdgeID e : problem->graph->edges_of(node)) {
-                    NodeID tgt = problem->graph->getEdgeTarget(node, e);
-                    if (!checked[tgt]) {
-                        checked[tgt] = true;
-                        block.emplace(tgt);
-                        ++vtcs;
-                    }
+        // bounds of a component include the lower bounds of the others
+        for (NodeID i = 0; i < split.size(); ++i) {
+            auto part = parts[i];
+            FlowType others = lower_sum
+                              - (part->lower_bound - problem->deleted_weight);
+            group->offset[i] += others;
+            part->deleted_weight += others;
+            part->lower_bound += others;
+            part->upper_bound += others;
+        }
 
-                    if (terminal[tgt]) {
-                        if (!t_this[tgt]) {
-                            t_this[tgt] = true;
-                            ++terms;
-                        }
-                    }
-                }
+        for (auto part : parts) {
+            updateBestSolution(part, part->upper_bound, false);
+        }
+
+        for (auto part : parts) {
+            if (part->lower_bound < upperBound(part)) {
+                problems.addProblem(part, thread_id);
             }
+        }
+        notifyIdle();
+
+        LOGC(testing) << "Split problem with " << problem->terminals.size()
+                      << " terminals into " << split.size()
+                      << " components";
+        return true;
+    }
+
+    // the first problem is improved by the primal heuristic right away,
+    // by an idle thread if there are several threads. afterwards, a copy
+    // of an open problem is offered to idle threads at most every
+    // heuristic_interval seconds
+    void primalHeuristic(std::shared_ptr<multicut_problem> problem) {
+        auto cfg = configuration::getConfig();
+        if (!cfg->heuristic_iterations
+            || problem->lower_bound >= upperBound(problem))
+            return;
+
+        bool root = !root_heuristic.exchange(true);
+        if (root && num_threads < 2) {
+            runHeuristic(problem);
+            return;
+        }
+
+        if (!root && (num_threads < 2 || idle_threads == 0
+                      || heuristic_offered
+                      || total_time.elapsed() < next_heuristic))
+            return;
+
+        auto copy = std::make_shared<multicut_problem>();
+        copy->graph = std::make_shared<mutable_graph>(*problem->graph);
+        copy->mappings = problem->mappings;
+        copy->lower_bound = problem->lower_bound;
+        copy->deleted_weight = problem->deleted_weight;
+        copy->group = problem->group;
+        copy->component = problem->component;
+
+        std::lock_guard<std::mutex> lck(heuristic_mutex);
+        if (!heuristic_offered) {
+            heuristic_problem = copy;
+            heuristic_offered = true;
+            next_heuristic = total_time.elapsed() + cfg->heuristic_interval;
+            notifyIdle();
+        }
+    }
 
-            if (terms)
-                LOG << "Number of terminals: " << terms
-                    << " with vertices " << vtcs;
+    bool runHeuristicTask() {
+        if (!heuristic_offered)
+            return false;
+
+        std::shared_ptr<multicut_problem> problem;
+        {
+            std::lock_guard<std::mutex> lck(heuristic_mutex);
+            problem = heuristic_problem;
+            heuristic_problem = nullptr;
+            heuristic_offered = false;
+        }
+        if (problem && problem->lower_bound < upperBound(problem)) {
+            runHeuristic(problem);
+        }
+        return problem != nullptr;
+    }
+
+    // the isolating blocks of the terminals have to be contracted, so the
+    // greedy growth of the heuristic starts from them
+    void runHeuristic(std::shared_ptr<multicut_problem> problem) {
+        auto cfg = configuration::getConfig();
+        auto G = problem->graph;
+        std::vector<NodeID> terminal_vertex;
+        for (NodeID t : original_terminals) {
+            terminal_vertex.emplace_back(
+                G->getCurrentPosition(problem->mapped(t)));
+        }
+
+        multicut_heuristic heuristic(G, terminal_vertex,
+                                     cfg->seed + heuristic_runs++);
+        std::vector<NodeID> block;
+        FlowType cut = heuristic.run(cfg->heuristic_iterations, &block)
+                       + problem->deleted_weight;
+        if (cut < upperBound(problem)) {
+            // the partition of a problem is recomputed before it is used
+            // again, so it can be overwritten here
+            for (NodeID n : G->nodes()) {
+                G->setPartitionIndex(n, block[n]);
+            }
+            updateBestSolution(problem, cut, false);
         }
     }
 
     mutable_graph original_graph;
     std::vector<NodeID> original_terminals;
-    FlowType global_upper_bound;
-    per_thread_problem_queue problems;
+    std::atomic<FlowType> global_upper_bound;
+    work_stealing_problem_queue problems;
+    disk_problem_queue spilled_problems;
+    uint64_t memory_budget;
     std::vector<NodeID> best_solution;
+    std::shared_ptr<solution_handle> best_handle;
     timer total_time;
 
     // parallel
@@ -659,10 +1392,39 @@ class branch_multicut {
     std::atomic<uint> idle_threads;
     size_t num_threads;
     std::vector<size_t> branch_invalid;
-    bool is_finished;
+    // workspaces of the sequential flow computations, one per thread
+    std::vector<push_relabel> flow_solvers;
+    std::vector<isolating_cuts> isolating_cut_solvers;
+    // flows of problems that idle threads help with
+    std::deque<std::function<void(size_t)> > flow_tasks;
+    std::mutex flow_task_mutex;
+    std::atomic<size_t> num_flow_tasks;
+    std::atomic<bool> is_finished;
 
     std::string edge_selection;
     kernelization_criteria kc;
+    transposition_table transpositions;
+    std::atomic<uint64_t> num_groups;
+    // solved by thread 0 when the threads are started
+    std::shared_ptr<multicut_problem> root_problem;
+    std::atomic<bool> root_heuristic;
+    std::atomic<bool> heuristic_offered;
+    std::atomic<double> next_heuristic;
+    std::atomic<size_t> heuristic_runs;
+    std::mutex heuristic_mutex;
+    std::shared_ptr<multicut_problem> heuristic_problem;
     std::atomic<double> log_timer;
     std::mutex bestsol_mutex;
+
+    static constexpr uint64_t checkpoint_magic = 0x544e494f504b4843;
+    std::atomic<bool> checkpoint_requested;
+    std::atomic<bool> stop_after_checkpoint;
+    std::atomic<bool> timed_out;
+    size_t paused_threads;
+    size_t checkpoint_round;
+    std::atomic<double> last_checkpoint;
+    std::mutex checkpoint_mutex;
+    std::condition_variable checkpoint_cv;
+    size_t checkpoint_component;
+    FlowType checkpoint_flow;
 };
@@ -0,0 +1,148 @@
+/******************************************************************************
+ * component_group.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "algorithms/multicut/multicut_problem.h"
+#include "common/definitions.h"
+
+// vertices of a problem that was split into independent components. both
+// vectors are indexed by the original vertices of the graph of the split
+// problem. vertices in a component with at least two terminals take their
+// block from the solution of that component, all other vertices are in the
+// block of the only terminal of their component.
+struct component_layout {
+    // maps from the original vertices to the vertices of the split problem
+    std::vector<std::shared_ptr<std::vector<NodeID> > > mappings;
+    // index of the component, UNDEFINED_NODE if the block is fixed
+    std::vector<NodeID> component;
+    std::vector<NodeID> block;
+};
+
+// partition of the problem that gave a solution. the assignment of the
+// original vertices is only computed in branch_multicut::bestSolution()
+struct solution_handle {
+    NodeID block(NodeID n) const {
+        if (layout) {
+            NodeID v = n;
+            for (const auto& map : layout->mappings) {
+                v = (*map)[v];
+            }
+            NodeID c = layout->component[v];
+            return c == UNDEFINED_NODE ? layout->block[v]
+                                       : parts[c]->block(n);
+        }
+        if (problem) {
+            NodeID n_coarse = problem->mapped(n);
+            auto t = problem->graph->getCurrentPosition(n_coarse);
+            return problem->graph->getPartitionIndex(t);
+        }
+        for (const auto& map : mappings) {
+            n = (*map)[n];
+        }
+        return blocks[n];
+    }
+
+    // leaf problem, its graph is not modified anymore
+    std::shared_ptr<multicut_problem> problem;
+    // for problems that are still worked on: block of each original
+    // vertex of the problem graph and the mappings to these vertices
+    std::vector<NodeID> blocks;
+    std::vector<std::shared_ptr<std::vector<NodeID> > > mappings;
+    // for split problems: the solutions of the components
+    std::shared_ptr<const component_layout> layout;
+    std::vector<std::shared_ptr<solution_handle> > parts;
+};
+
+// problem that was split into connected components with at least two
+// terminals each. every component is solved as a separate problem and the
+// multicut of the split problem is the sum of the multicuts of the
+// components. the bounds of the component problems are on the scale of the
+// split problem: component c adds offset[c], which is the deleted weight of
+// the split problem and the lower bounds of the other components.
+struct component_group {
+    component_group(std::shared_ptr<component_group> parent,
+                    size_t parent_component,
+                    FlowType base,
+                    size_t num_components,
+                    uint64_t id)
+        : id(id),
+          parent(parent),
+          parent_component(parent_component),
+          base(base),
+          offset(num_components, base),
+          best(num_components, std::numeric_limits<FlowType>::max()),
+          solutions(num_components) { }
+
+    // problems of component c with a lower bound of at least this value
+    // can not improve the best solution
+    FlowType upperBound(size_t c, FlowType global_upper_bound) {
+        FlowType bound = global_upper_bound;
+        if (parent) {
+            bound = parent->upperBound(parent_component, global_upper_bound);
+        }
+
+        std::lock_guard<std::mutex> lck(mutex);
+        if (best[c] < std::numeric_limits<FlowType>::max()) {
+            bound = std::min(bound, offset[c] + best[c]);
+        }
+        return bound;
+    }
+
+    // adds a solution of component c. if it is the best of its component
+    // and all components have a solution, returns the solution of the split
+    // problem and sets value to its multicut weight. otherwise returns
+    // nullptr
+    std::shared_ptr<solution_handle> addSolution(
+        size_t c, FlowType* value, std::shared_ptr<solution_handle> handle) {
+        std::lock_guard<std::mutex> lck(mutex);
+        FlowType component_value = *value - offset[c];
+        if (component_value >= best[c])
+            return nullptr;
+
+        best[c] = component_value;
+        solutions[c] = handle;
+
+        FlowType sum = base;
+        for (size_t i = 0; i < solutions.size(); ++i) {
+            if (!solutions[i])
+                return nullptr;
+            sum += best[i];
+        }
+
+        auto composed = std::make_shared<solution_handle>();
+        composed->layout = layout;
+        composed->parts = solutions;
+        *value = sum;
+        return composed;
+    }
+
+    // unique in a run of branch_multicut
+    uint64_t id;
+    std::shared_ptr<component_group> parent;
+    size_t parent_component;
+    // deleted weight of the split problem
+    FlowType base;
+    std::vector<FlowType> offset;
+    std::shared_ptr<const component_layout> layout;
+
+    std::mutex mutex;
+    // multicut weight of the best solution of each component, without the
+    // offset of the component
+    std::vector<FlowType> best;
+    std::vector<std::shared_ptr<solution_handle> > solutions;
+};
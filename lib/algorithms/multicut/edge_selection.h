@@ -21,90 +21,6 @@
 #include "data_structure/mutable_graph.h"
 #include "tools/random_functions.h"
 
-[[maybe_unused]] static std::tuple<NodeID, EdgeID> findHeavyEdge(
-    std::shared_ptr<multicut_problem> problem) {
-    EdgeWeight max_wgt = 0;
-    NodeID max_id_t = 0;
-    EdgeID max_id_e = 0;
-    for (const auto& term : problem->terminals) {
-        NodeID t = term.position;
-
-        for (EdgeID e : problem->graph->edges_of(t)) {
-            EdgeWeight curr_wgt = problem->graph->getEdgeWeight(t, e);
-            if (curr_wgt > max_wgt) {
-                max_wgt = curr_wgt;
-                max_id_t = t;
-                max_id_e = e;
-            }
-        }
-    }
-    return std::make_tuple(max_id_t, max_id_e);
-}
-
-[[maybe_unused]] static std::tuple<NodeID, EdgeID> findVertexWithHighDistance(
-    std::shared_ptr<multicut_problem> problem) {
-    EdgeWeight max_wgt = 0;
-    NodeID max_id_t = 0;
-    EdgeID max_id_e = 0;
-    for (const auto& term : problem->terminals) {
-        NodeID t = term.position;
-        for (EdgeID e : problem->graph->edges_of(t)) {
-            NodeID tgt = problem->graph->getEdgeTarget(t, e);
-            EdgeWeight curr_wgt = problem->graph->getWeightedNodeDegree(tgt)
-                                  - (problem->graph->getEdgeWeight(t, e));
-            if (curr_wgt > max_wgt) {
-                max_wgt = curr_wgt;
-                max_id_t = t;
-                max_id_e = e;
-            }
-        }
-    }
-    return std::make_tuple(max_id_t, max_id_e);
-}
-
-[[maybe_unused]] static std::tuple<NodeID, EdgeID> findHeavyVertex(
-    std::shared_ptr<multicut_problem> problem) {
-    EdgeWeight max_wgt = 0;
-    NodeID max_id_t = 0;
-    EdgeID max_id_e = 0;
-    for (const auto& term : problem->terminals) {
-        NodeID t = term.position;
-
-        if (problem->graph->get_first_invalid_edge(t) == 1) {
-            // return std::make_tuple(t, 0);
-        }
-
-        for (EdgeID e : problem->graph->edges_of(t)) {
-            NodeID tgt = problem->graph->getEdgeTarget(t, e);
-            EdgeWeight curr_wgt = problem->graph->getWeightedNodeDegree(tgt);
-            if (curr_wgt > max_wgt) {
-                max_wgt = curr_wgt;
-                max_id_t = t;
-                max_id_e = e;
-            }
-        }
-    }
-    return std::make_tuple(max_id_t, max_id_e);
-}
-
-[[maybe_unused]] static std::tuple<NodeID, EdgeID> findGlobalHeaviestEdge(
-    std::shared_ptr<multicut_problem> problem) {
-    EdgeWeight max_wgt = 0;
-    NodeID max_id_t = 0;
-    EdgeID max_id_e = 0;
-    for (NodeID n : problem->graph->nodes()) {
-        for (EdgeID e : problem->graph->edges_of(n)) {
-            EdgeWeight curr_wgt = problem->graph->getEdgeWeight(n, e);
-            if (curr_wgt > max_wgt) {
-                max_wgt = curr_wgt;
-                max_id_t = n;
-                max_id_e = e;
-            }
-        }
-    }
-    return std::make_tuple(max_id_t, max_id_e);
-}
-
 [[maybe_unused]] static std::tuple<NodeID, EdgeID> findEdgeWithManyTerminals(
     const std::shared_ptr<multicut_problem> problem) {
     std::unordered_map<NodeID, uint16_t> terms;
@@ -166,6 +82,174 @@
     return std::make_tuple(problem->terminals[t].position, e);
 }
 
+// candidate edges for branching, ordered by the score of an edge selection
+// rule. the graph of a problem and of its delete branches only loses edges
+// and the scores of all rules in edge_candidates::score only decrease.
+// thus, the candidates are kept in a lazy max-heap: the top is rescored
+// when it is selected and pushed back if its score decreased.
+//
+// the endpoints of a candidate are stored as original vertices of the
+// graph, so they stay valid when vertices are contracted. the contraction
+// of a branch edge can only increase the scores of the edges of the merged
+// vertex, these are pushed again in contracted(). after other contractions
+// the heap is rebuilt.
+struct edge_candidates {
+    enum rule { heavy, heavy_global, distance, heavy_vertex };
+
+    struct candidate {
+        bool operator < (const candidate& other) const {
+            return std::tie(score, other.source, other.target)
+                   < std::tie(other.score, source, target);
+        }
+
+        EdgeWeight score;
+        NodeID     source;
+        NodeID     target;
+    };
+
+    static EdgeWeight score(std::shared_ptr<mutable_graph> G, rule r,
+                            NodeID n, EdgeID e) {
+        NodeID tgt = G->getEdgeTarget(n, e);
+        switch (r) {
+        case heavy:
+        case heavy_global:
+            return G->getEdgeWeight(n, e);
+        case distance:
+            return G->getWeightedNodeDegree(tgt) - G->getEdgeWeight(n, e);
+        default:
+            return G->getWeightedNodeDegree(tgt);
+        }
+    }
+
+    void build(std::shared_ptr<multicut_problem> problem, rule r) {
+        auto G = problem->graph;
+        selection = r;
+        heap.clear();
+        if (r == heavy_global) {
+            for (NodeID n : G->nodes()) {
+                // each edge once for the global rule
+                add(G, n, true);
+            }
+        } else {
+            for (const auto& term : problem->terminals) {
+                add(G, term.position, false);
+            }
+        }
+        std::make_heap(heap.begin(), heap.end());
+        num_nodes = G->n();
+        built_size = heap.size();
+    }
+
+    // has to be called after the branch edge of the problem was contracted
+    // into vertex v and the edges between terminals were deleted
+    void contracted(std::shared_ptr<multicut_problem> problem, NodeID v) {
+        auto G = problem->graph;
+        size_t size = heap.size();
+        std::unordered_set<NodeID> terminal_set;
+        for (const auto& t : problem->terminals) {
+            terminal_set.emplace(t.position);
+        }
+
+        if (selection == heavy_global || terminal_set.count(v) > 0) {
+            add(G, v, false);
+        }
+        if (selection != heavy_global) {
+            // the edges of the terminals to v
+            for (EdgeID e : G->edges_of(v)) {
+                NodeID tgt = G->getEdgeTarget(v, e);
+                EdgeID rev = G->getReverseEdge(v, e);
+                EdgeWeight s = score(G, selection, tgt, rev);
+                if (s > 0 && terminal_set.count(tgt) > 0) {
+                    heap.push_back({ s, G->containedVertex(tgt),
+                                     G->containedVertex(v) });
+                }
+            }
+        }
+
+        for (size_t i = size; i < heap.size(); ++i) {
+            std::push_heap(heap.begin(), heap.begin() + i + 1);
+        }
+        num_nodes = G->n();
+    }
+
+    // returns the edge from source to target, UNDEFINED_EDGE if there is
+    // none. searches the smaller of both neighborhoods
+    static EdgeID findEdge(std::shared_ptr<mutable_graph> G,
+                           NodeID source, NodeID target) {
+        bool reverse = G->getNodeDegree(target) < G->getNodeDegree(source);
+        NodeID from = reverse ? target : source;
+        NodeID to = reverse ? source : target;
+        for (EdgeID e : G->edges_of(from)) {
+            if (G->getEdgeTarget(from, e) == to) {
+                return reverse ? G->getReverseEdge(from, e) : e;
+            }
+        }
+        return UNDEFINED_EDGE;
+    }
+
+    std::tuple<NodeID, EdgeID> top(std::shared_ptr<mutable_graph> G) {
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end());
+            candidate& c = heap.back();
+            NodeID source = G->getCurrentPosition(c.source);
+            NodeID target = G->getCurrentPosition(c.target);
+            EdgeID e = (source == target) ? UNDEFINED_EDGE
+                       : findEdge(G, source, target);
+            if (e != UNDEFINED_EDGE) {
+                EdgeWeight s = score(G, selection, source, e);
+                if (s == c.score) {
+                    std::push_heap(heap.begin(), heap.end());
+                    return std::make_tuple(source, e);
+                }
+                if (s > 0) {
+                    c.score = s;
+                    std::push_heap(heap.begin(), heap.end());
+                    continue;
+                }
+            }
+            heap.pop_back();
+        }
+        return std::make_tuple(0, 0);
+    }
+
+    rule                   selection;
+    // number of vertices of the graph the candidates belong to
+    NodeID                 num_nodes;
+    size_t                 built_size;
+    std::vector<candidate> heap;
+
+ private:
+    // adds the edges of n with a positive score. if unique is set, an edge
+    // is only added from its endpoint with the lower id
+    void add(std::shared_ptr<mutable_graph> G, NodeID n, bool unique) {
+        for (EdgeID e : G->edges_of(n)) {
+            NodeID tgt = G->getEdgeTarget(n, e);
+            EdgeWeight s = score(G, selection, n, e);
+            if (s > 0 && (!unique || n < tgt)) {
+                heap.push_back({ s, G->containedVertex(n),
+                                 G->containedVertex(tgt) });
+            }
+        }
+    }
+};
+
+// selection rules that only depend on the scores of single edges use the
+// candidate heap of the problem. it is shared with both branches until
+// they are materialized, see branch_token, so a materialized problem can
+// modify it. the heap is rebuilt if the graph was contracted outside of
+// the branching or if outdated candidates make up more than half of it.
+static std::tuple<NodeID, EdgeID> findCandidateEdge(
+    std::shared_ptr<multicut_problem> problem, edge_candidates::rule r) {
+    auto& candidates = problem->candidates;
+    if (!candidates || candidates->selection != r
+        || candidates->num_nodes != problem->graph->n()
+        || candidates->heap.size() > 2 * candidates->built_size) {
+        candidates = std::make_shared<edge_candidates>();
+        candidates->build(problem, r);
+    }
+    return candidates->top(problem->graph);
+}
+
 static std::tuple<NodeID, EdgeID> findEdge(
     std::shared_ptr<multicut_problem> problem,
     const std::string& edge_selection) {
@@ -174,19 +258,16 @@ static std::tuple<NodeID, EdgeID> findEdge(
         return findRandomEdge(problem);
 
     if (edge_selection == "heavy")
-        return findHeavyEdge(problem);
+        return findCandidateEdge(problem, edge_candidates::heavy);
 
     if (edge_selection == "heavy_global")
-        return findGlobalHeaviestEdge(problem);
+        return findCandidateEdge(problem, edge_candidates::heavy_global);
 
     if (edge_selection == "connection")
         return findEdgeWithManyTerminals(problem);
 
     if (edge_selection == "distance")
-        return findVertexWithHighDistance(problem);
-
-    if (edge_selection == "heavy_vertex")
-        return findHeavyVertex(problem);
+        return findCandidateEdge(problem, edge_candidates::distance);
 
-    return findHeavyVertex(problem);
+    return findCandidateEdge(problem, edge_candidates::heavy_vertex);
 }
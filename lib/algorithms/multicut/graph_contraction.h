@@ -12,7 +12,6 @@
 #pragma once
 
 #include <memory>
-#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -28,38 +27,31 @@ class graph_contraction {
     static void contractIsolatingBlocks(
         std::shared_ptr<multicut_problem> mcp,
         const std::vector<std::vector<NodeID> >& isolating_blocks) {
-        bool contracted = false;
-        std::vector<std::vector<NodeID> > contraction_base;
-        std::vector<bool> already_contracted;
+        NodeID n = mcp->graph->n();
+        std::vector<NodeID> mapping(n, UNDEFINED_NODE);
+        NodeID num_blocks = 0;
         for (const std::vector<NodeID>& isolating_block : isolating_blocks) {
-            contraction_base.emplace_back();
-            if (isolating_block.size() > 1 && !contracted) {
-                already_contracted.resize(mcp->graph->n(), false);
-                contracted = true;
-            }
-
             if (isolating_block.size() > 1) {
-                for (const NodeID& n : isolating_block) {
-                    if (!already_contracted[n]) {
-                        contraction_base.back().emplace_back(
-                            mcp->graph->containedVertices(n)[0]);
-                        already_contracted[n] = true;
+                bool new_block = false;
+                for (const NodeID& v : isolating_block) {
+                    if (mapping[v] == UNDEFINED_NODE) {
+                        mapping[v] = num_blocks;
+                        new_block = true;
                     }
                 }
+                num_blocks += new_block;
             }
         }
 
-        if (contracted) {
-            for (size_t i = 0; i < contraction_base.size(); ++i) {
-                if (contraction_base[i].size() > 1) {
-                    std::unordered_set<NodeID> vtx_to_ctr;
-                    for (auto v : contraction_base[i]) {
-                        NodeID n = mcp->graph->getCurrentPosition(v);
-                        vtx_to_ctr.emplace(n);
-                    }
-                    mcp->graph->contractVertexSet(vtx_to_ctr);
-                }
+        // all other vertices stay uncontracted
+        for (NodeID v = 0; v < n; ++v) {
+            if (mapping[v] == UNDEFINED_NODE) {
+                mapping[v] = num_blocks++;
             }
+        }
+
+        if (num_blocks < n) {
+            mcp->graph->contractPartition(mapping, num_blocks);
 
             if (debug) {
                 graph_algorithms::checkGraphValidity(mcp->graph);
@@ -109,10 +101,12 @@ class graph_contraction {
 
     static void setTerminals(std::shared_ptr<multicut_problem> problem,
                              const std::vector<NodeID>& original_terminals) {
-        std::unordered_map<NodeID, bool> invalid_flows;
+        // keyed by original id, as contractPartition renumbers all vertices
+        // and a position might belong to another terminal afterwards
+        std::vector<bool> invalid_flows(original_terminals.size(), true);
 
         for (const auto& t : problem->terminals) {
-            invalid_flows[t.position] = t.invalid_flow;
+            invalid_flows[t.original_id] = t.invalid_flow;
         }
 
         problem->terminals.clear();
@@ -122,9 +116,7 @@ class graph_contraction {
             NodeID node = problem->graph->getCurrentPosition(o);
             if ((problem->graph->getNodeDegree(node) > 0)
                 && (node < problem->graph->number_of_nodes())) {
-                NodeID n = invalid_flows.count(node);
-                bool flow_invalid = n == 0 || invalid_flows[node];
-                problem->terminals.emplace_back(node, i, flow_invalid);
+                problem->terminals.emplace_back(node, i, invalid_flows[i]);
             }
         }
     }
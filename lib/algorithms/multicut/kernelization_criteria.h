@@ -11,9 +11,12 @@
 
 #pragma once
 
+#include <omp.h>
+
+#include <algorithm>
 #include <memory>
 #include <string>
-#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "algorithms/global_mincut/noi_minimum_cut.h"
@@ -23,41 +26,70 @@
 #include "tlx/logger.hpp"
 #include "tlx/math.hpp"
 
+// Reduction rules for multiterminal cut problems, applied in rounds until
+// the graph does not shrink anymore. In every round, each rule scans the
+// graph with the given number of threads and collects its unions in
+// thread-local lists, which are then applied in vertex order. Vertices
+// contracted by an earlier rule of the same round are skipped by the later
+// rules and checked again in the next round. All unions of a round are
+// contracted at once.
 class kernelization_criteria {
  public:
     static constexpr bool debug = false;
+    // smaller graphs are kernelized by the calling thread only
+    static constexpr EdgeID parallel_edges = 1 << 20;
 
     kernelization_criteria(size_t contraction_type,
                            std::vector<NodeID> original_terminals)
         : contraction_type(contraction_type),
-          original_terminals(original_terminals) { }
+          original_terminals(original_terminals),
+          m_parallel_min_edges(parallel_edges) { }
 
     ~kernelization_criteria() { }
 
+    // num_threads > 1 should only be used by a thread that is not pinned to
+    // a single core, i.e. for the root problem in branch_multicut
     void perform_kernelization(std::shared_ptr<multicut_problem> mcp,
                                size_t global_upper_bound,
-                               EdgeWeight contracting_flow) {
+                               EdgeWeight contracting_flow,
+                               size_t num_threads = 1) {
         NodeID num_vtcs = mcp->graph->n();
         std::vector<bool> active_current(mcp->graph->getOriginalNodes(), true);
         std::vector<bool> active_next(mcp->graph->getOriginalNodes(), false);
         bool first_run = true;
         do {
             num_vtcs = mcp->graph->n();
+            size_t threads = mcp->graph->m() >= m_parallel_min_edges
+                             ? num_threads : 1;
+
+            graph_contraction::setTerminals(mcp, original_terminals);
+            std::vector<bool> terminals(num_vtcs, false);
+            for (const auto& p : mcp->terminals) {
+                terminals[p.position] = true;
+            }
+
+            union_find uf(num_vtcs);
+            // whether the set of a root contains a terminal
+            std::vector<bool> terminal_set = terminals;
+
             if (contraction_type < 4) {
-                auto uf_lowdegree = lowDegreeContraction(mcp);
-                contractIfImproved(&uf_lowdegree, mcp, "lowdeg", &active_next);
+                auto uf_lowdegree = lowDegreeContraction(mcp, terminals,
+                                                         threads);
+                addUnions(&uf, &uf_lowdegree, &terminal_set, "lowdeg");
             }
 
             if (contraction_type < 3) {
-                union_find uf_highdeg =
-                    highDegreeContraction(mcp, active_current);
-                contractIfImproved(
-                    &uf_highdeg, mcp, "high_degree", &active_next);
+                union_find uf_highdeg = highDegreeContraction(
+                    mcp, active_current, terminals,
+                    contractedVertices(&uf, num_vtcs), threads);
+                addUnions(&uf, &uf_highdeg, &terminal_set, "high_degree");
             }
 
             if (contraction_type < 2) {
-                auto uf_tri = triangleDetection(mcp, active_current);
-                contractIfImproved(&uf_tri, mcp, "triangle", &active_next);
+                auto uf_tri = triangleDetection(
+                    mcp, active_current, terminals,
+                    contractedVertices(&uf, num_vtcs), threads);
+                addUnions(&uf, &uf_tri, &terminal_set, "triangle");
             }
 
             if (contraction_type < 1) {
@@ -68,54 +100,111 @@ class kernelization_criteria {
 
                 if (first_run) {
                     auto uf_noi = noi.modified_capforest(mcp, noi_limit);
-                    contractIfImproved(&uf_noi, mcp, "noi", &active_next);
+                    addUnions(&uf, &uf_noi, &terminal_set, "noi");
                 }
             }
 
+            contractIfImproved(&uf, mcp, &active_next);
+
             first_run = false;
             active_next.swap(active_current);
             std::fill(active_next.begin(), active_next.end(), false);
         } while (mcp->graph->n() < num_vtcs);
     }
 
+    void setParallelMinEdges(EdgeID min_edges) {
+        m_parallel_min_edges = min_edges;
+    }
+
  private:
+    struct triangle {
+        NodeID v1, v2, v3;
+        bool heavy_v1, heavy_v2, heavy_v3;
+    };
+
+    // concatenates the thread-local lists and sorts them by first vertex.
+    // the lists of the threads are sorted already and the sort is stable,
+    // so the result is in the order of a sequential scan
+    template <typename T, typename F>
+    static std::vector<T> inScanOrder(std::vector<std::vector<T> >* local,
+                                      F first_vertex) {
+        std::vector<T> all;
+        for (auto& l : *local) {
+            all.insert(all.end(), l.begin(), l.end());
+        }
+        std::stable_sort(all.begin(), all.end(),
+                         [&first_vertex](const T& a, const T& b) {
+                             return first_vertex(a) < first_vertex(b);
+                         });
+        return all;
+    }
+
+    // adds the sets of rule_uf to uf. unions that would put two terminals
+    // into the same set are left out
+    void addUnions(union_find* uf, union_find* rule_uf,
+                   std::vector<bool>* terminal_set, const std::string& str) {
+        std::vector<bool>& term = *terminal_set;
+        NodeID before = uf->n();
+        for (NodeID n = 0; n < term.size(); ++n) {
+            NodeID r1 = uf->Find(n);
+            NodeID r2 = uf->Find(rule_uf->Find(n));
+            if (r1 == r2 || (term[r1] && term[r2]))
+                continue;
+
+            bool has_terminal = term[r1] || term[r2];
+            uf->Union(r1, r2);
+            term[uf->Find(r1)] = has_terminal;
+        }
+
+        if (uf->n() < before) {
+            LOGC(logs) << str << " contracts " << before << " to " << uf->n();
+        }
+    }
+
+    // whether a vertex is in a set with other vertices
+    std::vector<bool> contractedVertices(union_find* uf, NodeID num_vtcs) {
+        std::vector<bool> contracted(num_vtcs, false);
+        if (uf->n() == num_vtcs)
+            return contracted;
+
+        std::vector<NodeID> set_size(num_vtcs, 0);
+        for (NodeID n = 0; n < num_vtcs; ++n) {
+            ++set_size[uf->Find(n)];
+        }
+        for (NodeID n = 0; n < num_vtcs; ++n) {
+            contracted[n] = set_size[uf->Find(n)] > 1;
+        }
+        return contracted;
+    }
+
     void contractIfImproved(union_find* uf,
                             std::shared_ptr<multicut_problem> problem,
-                            const std::string& str,
                             std::vector<bool>* active_vertices) {
         std::vector<bool>& active = *active_vertices;
 
         if (uf->n() < problem->graph->number_of_nodes()) {
-            LOGC(logs) << str << " contracts "
+            LOGC(logs) << "kernelization contracts "
                        << problem->graph->n() << " to " << uf->n();
 
-            std::vector<std::vector<NodeID> > reverse_mapping(uf->n());
-            // code duplicated from contract graph
-            // as we need access to vertex sets
             std::vector<NodeID> part(
                 problem->graph->number_of_nodes(), UNDEFINED_NODE);
-            NodeID current_pid = 0;
+            std::vector<NodeID> mapping(problem->graph->number_of_nodes());
+            std::vector<NodeID> block_size;
             for (NodeID n : problem->graph->nodes()) {
                 NodeID part_id = uf->Find(n);
                 if (part[part_id] == UNDEFINED_NODE) {
-                    part[part_id] = current_pid++;
+                    part[part_id] = block_size.size();
+                    block_size.emplace_back(0);
                 }
-                reverse_mapping[part[part_id]].push_back(
-                    problem->graph->containedVertices(n)[0]);
+                mapping[n] = part[part_id];
+                ++block_size[mapping[n]];
             }
 
-            for (size_t i = 0; i < reverse_mapping.size(); ++i) {
-                if (reverse_mapping[i].size() > 1) {
-                    std::unordered_set<NodeID> vtx_to_ctr;
-                    for (auto v : reverse_mapping[i]) {
-                        vtx_to_ctr.emplace(
-                            problem->graph->getCurrentPosition(v));
-                    }
-                    problem->graph->contractVertexSet(vtx_to_ctr);
-
-                    NodeID c = problem->graph->getCurrentPosition(
-                        reverse_mapping[i][0]);
+            problem->graph->contractPartition(mapping, block_size.size());
 
+            // contracted vertices and their neighbours are active
+            for (NodeID c : problem->graph->nodes()) {
+                if (block_size[c] > 1) {
                     for (const NodeID& n :
                          problem->graph->containedVertices(c)) {
                         active[n] = true;
@@ -139,147 +228,165 @@ class kernelization_criteria {
         }
     }
 
-    union_find lowDegreeContraction(std::shared_ptr<multicut_problem> problem) {
-        union_find uf(problem->graph->number_of_nodes());
-        graph_contraction::setTerminals(problem, original_terminals);
-        std::vector<bool> terminals(problem->graph->number_of_nodes(), false);
+    union_find lowDegreeContraction(std::shared_ptr<multicut_problem> problem,
+                                    const std::vector<bool>& terminals,
+                                    size_t threads) {
         auto graph = problem->graph;
+        NodeID num_vtcs = graph->number_of_nodes();
+        std::vector<std::vector<std::pair<NodeID, NodeID> > > local(threads);
+
+#pragma omp parallel num_threads(threads)
+        {
+            auto& unions = local[omp_get_thread_num()];
+#pragma omp for schedule(dynamic, 1024)
+            for (NodeID n = 0; n < num_vtcs; ++n) {
+                if (terminals[n])
+                    continue;
 
-        for (const auto& p : problem->terminals) {
-            terminals[p.position] = true;
-        }
+                if (graph->getNodeDegree(n) == 1) {
+                    NodeID tgt = graph->getEdgeTarget(n, 0);
+                    unions.emplace_back(n, tgt);
 
-        for (NodeID n : graph->nodes()) {
-            if (terminals[n])
-                continue;
+                    if (graph->getNodeDegree(tgt) == 3) {
+                        // this will become a degree 2 vertex
+                        // so we run the degree 2 contraction
 
-            if (graph->getNodeDegree(n) == 1) {
-                NodeID tgt = graph->getEdgeTarget(n, 0);
-                uf.Union(n, tgt);
+                        EdgeID reverse = graph->getReverseEdge(n, 0);
+                        EdgeID non_n_1 = 0 + (reverse == 0);
+                        EdgeID non_n_2 = 1 + (reverse <= 1);
 
-                if (graph->getNodeDegree(tgt) == 3) {
-                    // this will become a degree 2 vertex
-                    // so we run the degree 2 contraction
+                        NodeID n1 = graph->getEdgeTarget(tgt, non_n_1);
+                        NodeID n2 = graph->getEdgeTarget(tgt, non_n_2);
+                        EdgeWeight e1 = graph->getEdgeWeight(tgt, non_n_1);
+                        EdgeWeight e2 = graph->getEdgeWeight(tgt, non_n_2);
 
-                    EdgeID reverse = graph->getReverseEdge(n, 0);
-                    EdgeID non_n_1 = 0 + (reverse == 0);
-                    EdgeID non_n_2 = 1 + (reverse <= 1);
+                        // merge with stronger connected neighbour
+                        NodeID larger = e1 >= e2 ? n1 : n2;
+                        unions.emplace_back(tgt, larger);
+                    }
+                    continue;
+                }
 
-                    NodeID n1 = graph->getEdgeTarget(tgt, non_n_1);
-                    NodeID n2 = graph->getEdgeTarget(tgt, non_n_2);
-                    EdgeWeight e1 = graph->getEdgeWeight(tgt, non_n_1);
-                    EdgeWeight e2 = graph->getEdgeWeight(tgt, non_n_2);
+                if (graph->getNodeDegree(n) == 2) {
+                    NodeID n1 = graph->getEdgeTarget(n, 0);
+                    NodeID n2 = graph->getEdgeTarget(n, 1);
+                    EdgeWeight e1 = graph->getEdgeWeight(n, 0);
+                    EdgeWeight e2 = graph->getEdgeWeight(n, 1);
 
                     // merge with stronger connected neighbour
                     NodeID larger = e1 >= e2 ? n1 : n2;
-                    uf.Union(tgt, larger);
+                    unions.emplace_back(n, larger);
                 }
-                continue;
             }
+        }
 
-            if (graph->getNodeDegree(n) == 2) {
-                NodeID n1 = graph->getEdgeTarget(n, 0);
-                NodeID n2 = graph->getEdgeTarget(n, 1);
-                EdgeWeight e1 = graph->getEdgeWeight(n, 0);
-                EdgeWeight e2 = graph->getEdgeWeight(n, 1);
-
-                // merge with stronger connected neighbour
-                NodeID larger = e1 >= e2 ? n1 : n2;
-                uf.Union(n, larger);
+        union_find uf(num_vtcs);
+        for (const auto& l : local) {
+            for (const auto& [n, tgt] : l) {
+                uf.Union(n, tgt);
             }
         }
         return uf;
     }
 
     union_find highDegreeContraction(std::shared_ptr<multicut_problem> problem,
-                                     const std::vector<bool>& active) {
-        graph_contraction::setTerminals(problem, original_terminals);
-        union_find uf(problem->graph->number_of_nodes());
-        std::vector<bool> terminals(problem->graph->number_of_nodes(), false);
-
-        for (const auto& p : problem->terminals) {
-            terminals[p.position] = true;
-        }
-
+                                     const std::vector<bool>& active,
+                                     const std::vector<bool>& terminals,
+                                     const std::vector<bool>& contracted,
+                                     size_t threads) {
         auto graph = problem->graph;
+        NodeID num_vtcs = graph->number_of_nodes();
+        // at most one candidate union per vertex
+        std::vector<std::vector<std::pair<NodeID, NodeID> > > local(threads);
+
+#pragma omp parallel num_threads(threads)
+        {
+            auto& unions = local[omp_get_thread_num()];
+#pragma omp for schedule(dynamic, 1024)
+            for (NodeID n = 0; n < num_vtcs; ++n) {
+                NodeID in = graph->containedVertices(n)[0];
+                if (!active[in] || terminals[n] || contracted[n]) {
+                    continue;
+                }
 
-        for (NodeID n : graph->nodes()) {
-            NodeID in = graph->containedVertices(n)[0];
-            if (!active[in]) {
-                continue;
-            }
-
-            if (terminals[n] || uf.Find(n) != n)
-                continue;
-
-            EdgeWeight nonterminal_weight = 0;
-            EdgeWeight maxwgt = 0;
-            NodeID maxterm = 0;
-
-            EdgeWeight secondwgt = 0;
-
-            EdgeWeight node_weight = graph->getWeightedNodeDegree(n);
-            bool already_contracted = false;
-            for (EdgeID e : graph->edges_of(n)) {
-                NodeID tgt = graph->getEdgeTarget(n, e);
-                EdgeWeight wgt = graph->getEdgeWeight(n, e);
-
-                if (terminals[tgt]) {
-                    if (wgt > maxwgt) {
-                        secondwgt = maxwgt;
-                        maxwgt = wgt;
-                        maxterm = tgt;
-                    } else {
-                        if (wgt > secondwgt) {
-                            secondwgt = wgt;
+                EdgeWeight nonterminal_weight = 0;
+                EdgeWeight maxwgt = 0;
+                NodeID maxterm = 0;
+
+                EdgeWeight secondwgt = 0;
+
+                EdgeWeight node_weight = graph->getWeightedNodeDegree(n);
+                bool already_contracted = false;
+                for (EdgeID e : graph->edges_of(n)) {
+                    NodeID tgt = graph->getEdgeTarget(n, e);
+                    EdgeWeight wgt = graph->getEdgeWeight(n, e);
+
+                    if (terminals[tgt]) {
+                        if (wgt > maxwgt) {
+                            secondwgt = maxwgt;
+                            maxwgt = wgt;
+                            maxterm = tgt;
+                        } else {
+                            if (wgt > secondwgt) {
+                                secondwgt = wgt;
+                            }
                         }
                     }
-                }
 
-                if (wgt * 2 >= node_weight) {
-                    uf.Union(n, tgt);
-                    already_contracted = true;
-                    break;
-                }
+                    if (wgt * 2 >= node_weight) {
+                        unions.emplace_back(n, tgt);
+                        already_contracted = true;
+                        break;
+                    }
 
-                if (!terminals[tgt]) {
-                    nonterminal_weight += wgt;
+                    if (!terminals[tgt]) {
+                        nonterminal_weight += wgt;
+                    }
                 }
-            }
 
-            if (!already_contracted) {
-                if (maxwgt > nonterminal_weight + secondwgt) {
-                    uf.Union(n, maxterm);
+                if (!already_contracted) {
+                    if (maxwgt > nonterminal_weight + secondwgt) {
+                        unions.emplace_back(n, maxterm);
+                    }
                 }
             }
         }
 
+        // vertices that were merged into a previous vertex are skipped
+        union_find uf(num_vtcs);
+        auto unions = inScanOrder(
+            &local, [](const std::pair<NodeID, NodeID>& p) {
+                        return p.first;
+                    });
+        for (const auto& [n, tgt] : unions) {
+            if (uf.Find(n) == n) {
+                uf.Union(n, tgt);
+            }
+        }
         return uf;
     }
 
     union_find triangleDetection(std::shared_ptr<multicut_problem> mcp,
-                                 const std::vector<bool>& active) {
+                                 const std::vector<bool>& active,
+                                 const std::vector<bool>& terminals,
+                                 const std::vector<bool>& contracted,
+                                 size_t threads) {
         auto graph = mcp->graph;
+        NodeID num_vtcs = graph->number_of_nodes();
+        std::vector<std::vector<triangle> > local(threads);
+
+#pragma omp parallel num_threads(threads)
+        {
+            auto& triangles = local[omp_get_thread_num()];
+            std::vector<EdgeID> marked(num_vtcs, UNDEFINED_EDGE);
+#pragma omp for schedule(dynamic, 1024)
+            for (NodeID v1 = 0; v1 < num_vtcs; ++v1) {
+                NodeID in = graph->containedVertices(v1)[0];
+                if (!active[in] || terminals[v1] || contracted[v1]) {
+                    continue;
+                }
 
-        graph_contraction::setTerminals(mcp, original_terminals);
-        union_find uf(mcp->graph->number_of_nodes());
-        std::vector<bool> terminals(mcp->graph->number_of_nodes(), false);
-
-        for (const auto& p : mcp->terminals) {
-            terminals[p.position] = true;
-        }
-
-        std::vector<EdgeID> marked(mcp->graph->n(), UNDEFINED_EDGE);
-        std::vector<bool> done(mcp->graph->n(), false);
-
-        for (NodeID v1 : graph->nodes()) {
-            NodeID in = graph->containedVertices(v1)[0];
-            if (!active[in]) {
-                continue;
-            }
-
-            EdgeWeight maxwgt = 0;
-            if (!done[v1] && !terminals[v1]) {
+                EdgeWeight maxwgt = 0;
                 for (EdgeID e : graph->edges_of(v1)) {
                     NodeID tgt = graph->getEdgeTarget(v1, e);
                     EdgeWeight wgt = graph->getEdgeWeight(v1, e);
@@ -303,63 +410,72 @@ class kernelization_criteria {
 
                 for (EdgeID e1 : graph->edges_of(v1)) {
                     NodeID v2 = graph->getEdgeTarget(v1, e1);
-                    if (v2 > v1 && !terminals[v2] && !done[v2]) {
+                    if (v2 <= v1)
+                        continue;
+
+                    if (!terminals[v2] && !contracted[v2]) {
                         for (EdgeID e2 : graph->edges_of(v2)) {
                             NodeID v3 = graph->getEdgeTarget(v2, e2);
                             if (v3 > v2 && marked[v3] != UNDEFINED_EDGE
-                                && !terminals[v3] && !done[v3]) {
+                                && !terminals[v3] && !contracted[v3]) {
                                 EdgeID e3 = marked[v3];
-                                if (graph->getEdgeTarget(v1, e3) == v3) {
-                                    EdgeWeight weight_v1 =
-                                        graph->getWeightedNodeDegree(v1);
-                                    EdgeWeight weight_v2 =
-                                        graph->getWeightedNodeDegree(v2);
-                                    EdgeWeight weight_v3 =
-                                        graph->getWeightedNodeDegree(v3);
-
-                                    EdgeWeight weight_e1 =
-                                        graph->getEdgeWeight(v1, e1);
-                                    EdgeWeight weight_e2 =
-                                        graph->getEdgeWeight(v2, e2);
-                                    EdgeWeight weight_e3 =
-                                        graph->getEdgeWeight(v1, e3);
-
-                                    bool heavy_v1 =
-                                        ((weight_v1 <=
-                                          (weight_e1 + weight_e3) * 2)
-                                         && (uf.Find(v1) == v1));
-                                    bool heavy_v2 =
-                                        ((weight_v2 <=
-                                          (weight_e1 + weight_e2) * 2)
-                                         && (uf.Find(v2) == v2));
-                                    bool heavy_v3 =
-                                        ((weight_v3 <=
-                                          (weight_e2 + weight_e3) * 2)
-                                         && (uf.Find(v3) == v3));
-
-                                    if (heavy_v1 && heavy_v2)
-                                        uf.Union(v1, v2);
-
-                                    if (heavy_v1 && heavy_v3)
-                                        uf.Union(v1, v3);
-
-                                    if (heavy_v2 && heavy_v3)
-                                        uf.Union(v2, v3);
-                                } else {
+                                if (graph->getEdgeTarget(v1, e3) != v3) {
                                     LOG1 << "Graph corrupted!";
                                     exit(1);
                                 }
+
+                                EdgeWeight weight_e1 =
+                                    graph->getEdgeWeight(v1, e1);
+                                EdgeWeight weight_e2 =
+                                    graph->getEdgeWeight(v2, e2);
+                                EdgeWeight weight_e3 =
+                                    graph->getEdgeWeight(v1, e3);
+
+                                triangle t;
+                                t.v1 = v1;
+                                t.v2 = v2;
+                                t.v3 = v3;
+                                t.heavy_v1 = graph->getWeightedNodeDegree(v1)
+                                             <= (weight_e1 + weight_e3) * 2;
+                                t.heavy_v2 = graph->getWeightedNodeDegree(v2)
+                                             <= (weight_e1 + weight_e2) * 2;
+                                t.heavy_v3 = graph->getWeightedNodeDegree(v3)
+                                             <= (weight_e2 + weight_e3) * 2;
+
+                                if (t.heavy_v1 + t.heavy_v2 + t.heavy_v3 > 1)
+                                    triangles.emplace_back(t);
                             }
                         }
-                        marked[v2] = UNDEFINED_EDGE;
                     }
+                    marked[v2] = UNDEFINED_EDGE;
                 }
             }
         }
+
+        // a vertex that was merged into a previous vertex is not heavy
+        union_find uf(num_vtcs);
+        auto triangles = inScanOrder(&local, [](const triangle& t) {
+                                                 return t.v1;
+                                             });
+        for (const triangle& t : triangles) {
+            bool heavy_v1 = t.heavy_v1 && uf.Find(t.v1) == t.v1;
+            bool heavy_v2 = t.heavy_v2 && uf.Find(t.v2) == t.v2;
+            bool heavy_v3 = t.heavy_v3 && uf.Find(t.v3) == t.v3;
+
+            if (heavy_v1 && heavy_v2)
+                uf.Union(t.v1, t.v2);
+
+            if (heavy_v1 && heavy_v3)
+                uf.Union(t.v1, t.v3);
+
+            if (heavy_v2 && heavy_v3)
+                uf.Union(t.v2, t.v3);
+        }
         return uf;
     }
 
     size_t contraction_type;
     std::vector<NodeID> original_terminals;
+    EdgeID m_parallel_min_edges;
     constexpr static bool logs = false;
 };
@@ -0,0 +1,361 @@
+/******************************************************************************
+ * multicut_heuristic.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <queue>
+#include <random>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+
+// Primal heuristic for the multiterminal cut of a problem graph, used to
+// find good upper bounds early in branch_multicut.
+//
+// The blocks are grown greedily by edge weight from the terminal vertices.
+// In branch_multicut, the terminals already contain the source sides of
+// their isolating flows, so the growth only has to assign the remaining
+// vertices. The solution is then improved by FM-style local search and an
+// iterated local search, which moves a small region of a random vertex to
+// a neighboring block and runs the local search around that region. The
+// cut weight is updated with the gains of the moves, a round that does
+// not improve the solution is undone. The terminal vertices are fixed in
+// their block.
+class multicut_heuristic {
+ public:
+    // if local search only found worse solutions for this many moves, the
+    // pass is stopped and the moves after the best solution are undone
+    static constexpr size_t max_unimproving_moves = 100;
+    // maximum number of vertices moved in a perturbation
+    static constexpr size_t max_perturbation = 16;
+
+    // terminal_vertex contains the vertex of each block, at least two
+    multicut_heuristic(std::shared_ptr<mutable_graph> G,
+                       const std::vector<NodeID>& terminal_vertex,
+                       size_t seed)
+        : G(G),
+          terminal_vertex(terminal_vertex),
+          fixed(G->n(), false),
+          connection(terminal_vertex.size(), 0),
+          locked(G->n(), false),
+          stamp(G->n(), 0),
+          mt(seed) {
+        for (NodeID t : terminal_vertex) {
+            fixed[t] = true;
+        }
+    }
+
+    // writes the block of every vertex to block and returns the weight of
+    // the multiterminal cut
+    FlowType run(size_t iterations, std::vector<NodeID>* block) {
+        greedyGrowth(block);
+        std::vector<NodeID> all;
+        for (NodeID n : G->nodes()) {
+            all.emplace_back(n);
+        }
+        FlowType best = cutWeight(*block);
+        best -= localSearch(block, all);
+
+        std::vector<NodeID>& b = *block;
+        for (size_t i = 0; i < iterations; ++i) {
+            undo.clear();
+            FlowType weight = best - perturb(block);
+            // the surrounding of the moved region adapts to it first,
+            // otherwise the local search mostly reverts the perturbation
+            for (NodeID v : perturbed) {
+                fixed[v] = true;
+            }
+            weight -= localSearch(block, region(false));
+            for (NodeID v : perturbed) {
+                fixed[v] = false;
+            }
+            weight -= localSearch(block, region(true));
+
+            if (weight < best) {
+                best = weight;
+            } else {
+                for (size_t j = undo.size(); j-- > 0; ) {
+                    b[undo[j].first] = undo[j].second;
+                }
+            }
+        }
+        return best;
+    }
+
+    FlowType cutWeight(const std::vector<NodeID>& block) {
+        FlowType weight = 0;
+        for (NodeID n : G->nodes()) {
+            for (EdgeID e : G->edges_of(n)) {
+                NodeID tgt = G->getEdgeTarget(n, e);
+                if (n < tgt && block[n] != block[tgt]) {
+                    weight += G->getEdgeWeight(n, e);
+                }
+            }
+        }
+        return weight;
+    }
+
+ private:
+    // grows the blocks from the terminal vertices by edge weight. the next
+    // vertex is the one with the heaviest connection to a block, it joins
+    // that block. vertices that are not connected to a terminal join the
+    // block of the terminal with the highest degree
+    void greedyGrowth(std::vector<NodeID>* block) {
+        std::vector<NodeID>& b = *block;
+        b.assign(G->n(), UNDEFINED_NODE);
+        NodeID k = terminal_vertex.size();
+        // weight of the edges of an unassigned vertex v to block l,
+        // stored at v * k + l
+        std::unordered_map<uint64_t, EdgeWeight> weight_to_block;
+        std::priority_queue<std::tuple<EdgeWeight, NodeID, NodeID> > growth;
+        auto assign = [&](NodeID v, NodeID l) {
+                          b[v] = l;
+                          for (EdgeID e : G->edges_of(v)) {
+                              NodeID tgt = G->getEdgeTarget(v, e);
+                              if (b[tgt] == UNDEFINED_NODE) {
+                                  EdgeWeight& w =
+                                      weight_to_block[uint64_t { tgt } * k + l];
+                                  w += G->getEdgeWeight(v, e);
+                                  growth.emplace(w, tgt, l);
+                              }
+                          }
+                      };
+
+        NodeID heaviest = 0;
+        for (NodeID l = 0; l < k; ++l) {
+            if (G->getWeightedNodeDegree(terminal_vertex[l])
+                > G->getWeightedNodeDegree(terminal_vertex[heaviest])) {
+                heaviest = l;
+            }
+            b[terminal_vertex[l]] = l;
+        }
+
+        for (NodeID l = 0; l < k; ++l) {
+            assign(terminal_vertex[l], l);
+        }
+
+        while (!growth.empty()) {
+            auto [wgt, v, l] = growth.top();
+            growth.pop();
+            // outdated entries have a lower weight than the current one
+            if (b[v] == UNDEFINED_NODE
+                && wgt == weight_to_block[uint64_t { v } * k + l]) {
+                assign(v, l);
+            }
+        }
+
+        for (NodeID n : G->nodes()) {
+            if (b[n] == UNDEFINED_NODE) {
+                b[n] = heaviest;
+            }
+        }
+    }
+
+    // best move of vertex v to another block. returns false if v has no
+    // neighbor in another block
+    bool bestMove(const std::vector<NodeID>& block, NodeID v,
+                  FlowType* gain, NodeID* target) {
+        for (EdgeID e : G->edges_of(v)) {
+            NodeID tgt = G->getEdgeTarget(v, e);
+            // a self-loop is never cut, it would distort the gain
+            if (tgt == v)
+                continue;
+            NodeID b = block[tgt];
+            if (!connection[b]) {
+                touched.emplace_back(b);
+            }
+            connection[b] += G->getEdgeWeight(v, e);
+        }
+
+        bool found = false;
+        FlowType internal = connection[block[v]];
+        for (NodeID b : touched) {
+            FlowType g = static_cast<FlowType>(connection[b]) - internal;
+            if (b != block[v] && (!found || g > *gain)) {
+                *gain = g;
+                *target = b;
+                found = true;
+            }
+            connection[b] = 0;
+        }
+        touched.clear();
+        return found;
+    }
+
+    void pushMove(const std::vector<NodeID>& block, NodeID v) {
+        FlowType gain;
+        NodeID target;
+        stamp[v]++;
+        if (!fixed[v] && !locked[v]
+            && bestMove(block, v, &gain, &target)) {
+            moves.emplace(gain, v, target, stamp[v]);
+        }
+    }
+
+    // decrease of the cut weight if v is moved to block target
+    FlowType moveGain(const std::vector<NodeID>& block, NodeID v,
+                      NodeID target) {
+        FlowType gain = 0;
+        for (EdgeID e : G->edges_of(v)) {
+            NodeID tgt = G->getEdgeTarget(v, e);
+            if (tgt != v && block[tgt] == target) {
+                gain += G->getEdgeWeight(v, e);
+            } else if (tgt != v && block[tgt] == block[v]) {
+                gain -= G->getEdgeWeight(v, e);
+            }
+        }
+        return gain;
+    }
+
+    // FM passes starting from the vertices in seeds, until a pass does not
+    // improve the solution. every further pass starts from the vertices
+    // around the moves kept in the previous one. the kept moves are
+    // appended to undo, returns the decrease of the cut weight
+    FlowType localSearch(std::vector<NodeID>* block,
+                         std::vector<NodeID> seeds) {
+        std::vector<NodeID>& b = *block;
+        FlowType total = 0;
+        FlowType improvement = 1;
+        while (improvement > 0) {
+            moves = decltype(moves)();
+            for (NodeID n : seeds) {
+                pushMove(b, n);
+            }
+
+            // vertex and its previous block for every move of this pass
+            std::vector<std::pair<NodeID, NodeID> > moved;
+            FlowType sum = 0;
+            improvement = 0;
+            size_t best_moves = 0;
+            while (!moves.empty()
+                   && moved.size() < best_moves + max_unimproving_moves) {
+                auto [gain, v, target, s] = moves.top();
+                moves.pop();
+                if (locked[v] || s != stamp[v])
+                    continue;
+
+                moved.emplace_back(v, b[v]);
+                b[v] = target;
+                locked[v] = true;
+                sum += gain;
+                if (sum > improvement) {
+                    improvement = sum;
+                    best_moves = moved.size();
+                }
+
+                for (EdgeID e : G->edges_of(v)) {
+                    pushMove(b, G->getEdgeTarget(v, e));
+                }
+            }
+
+            seeds.clear();
+            for (size_t i = moved.size(); i-- > 0; ) {
+                auto [v, previous] = moved[i];
+                if (i >= best_moves) {
+                    b[v] = previous;
+                } else {
+                    seeds.emplace_back(v);
+                    for (EdgeID e : G->edges_of(v)) {
+                        seeds.emplace_back(G->getEdgeTarget(v, e));
+                    }
+                }
+                locked[v] = false;
+            }
+            undo.insert(undo.end(), moved.begin(), moved.begin() + best_moves);
+            total += improvement;
+        }
+        return total;
+    }
+
+    // neighbors of the perturbed vertices, including the perturbed
+    // vertices themselves if with_perturbed is set
+    std::vector<NodeID> region(bool with_perturbed) {
+        std::vector<NodeID> r;
+        for (NodeID v : perturbed) {
+            if (with_perturbed) {
+                r.emplace_back(v);
+            }
+            for (EdgeID e : G->edges_of(v)) {
+                r.emplace_back(G->getEdgeTarget(v, e));
+            }
+        }
+        std::sort(r.begin(), r.end());
+        r.erase(std::unique(r.begin(), r.end()), r.end());
+        return r;
+    }
+
+    // moves a region around a random vertex to the block of one of its
+    // neighbors, the vertices of the region are stored in perturbed and
+    // the moves in undo. returns the decrease of the cut weight
+    FlowType perturb(std::vector<NodeID>* block) {
+        std::vector<NodeID>& b = *block;
+        std::uniform_int_distribution<NodeID> vertex(0, G->n() - 1);
+        NodeID v = vertex(mt);
+        perturbed.clear();
+        if (fixed[v] || !G->getNodeDegree(v))
+            return 0;
+
+        std::uniform_int_distribution<EdgeID> edge(0, G->getNodeDegree(v) - 1);
+        NodeID target = b[G->getEdgeTarget(v, edge(mt))];
+        if (target == b[v]) {
+            // any other block
+            std::uniform_int_distribution<NodeID> random_block(
+                0, terminal_vertex.size() - 2);
+            target = random_block(mt);
+            target += (target >= b[v]);
+        }
+
+        std::uniform_int_distribution<size_t> size(1, max_perturbation);
+        size_t region_size = size(mt);
+        NodeID source = b[v];
+        FlowType gain = 0;
+        auto move = [&](NodeID u) {
+                        gain += moveGain(b, u, target);
+                        undo.emplace_back(u, source);
+                        b[u] = target;
+                        perturbed.emplace_back(u);
+                    };
+
+        move(v);
+        for (size_t i = 0; i < perturbed.size(); ++i) {
+            NodeID u = perturbed[i];
+            for (EdgeID e : G->edges_of(u)) {
+                NodeID tgt = G->getEdgeTarget(u, e);
+                if (perturbed.size() < region_size
+                    && b[tgt] == source && !fixed[tgt]) {
+                    move(tgt);
+                }
+            }
+        }
+        return gain;
+    }
+
+    std::shared_ptr<mutable_graph> G;
+    std::vector<NodeID> terminal_vertex;
+    std::vector<bool> fixed;
+    std::vector<NodeID> perturbed;
+    // vertex and its previous block for every move of the current round
+    std::vector<std::pair<NodeID, NodeID> > undo;
+    // weight of the edges to each block, only used in bestMove
+    std::vector<EdgeWeight> connection;
+    std::vector<NodeID> touched;
+    std::vector<bool> locked;
+    // moves of vertices with an outdated stamp are ignored
+    std::vector<size_t> stamp;
+    std::priority_queue<std::tuple<FlowType, NodeID, NodeID, size_t> > moves;
+    std::mt19937 mt;
+};
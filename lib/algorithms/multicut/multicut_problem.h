@@ -11,11 +11,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <limits>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "algorithms/flow/push_relabel.h"
 #include "data_structure/mutable_graph.h"
 
 struct terminal {
@@ -34,8 +36,36 @@ struct terminal {
     bool   invalid_flow;
 };
 
+// modification of the graph of a multicut_problem that was not yet applied.
+// vertex and edge refer to the graph before the modification.
+struct graph_delta {
+    enum operation { delete_edge, contract_edge };
+
+    graph_delta(operation op, NodeID vertex, EdgeID edge)
+        : op(op), vertex(vertex), edge(edge) { }
+
+    operation op;
+    NodeID    vertex;
+    EdgeID    edge;
+};
+
+// the two problems created in branchOnEdge share the graph, vertex keys and
+// candidates of their parent until they are materialized. the first one
+// works on copies and releases the token afterwards, the one that finds the
+// token released owns the shared data and modifies it in place. a problem
+// that is dropped or spilled before it is materialized releases the token.
+struct branch_token {
+    branch_token() : released(false) { }
+
+    std::atomic<bool> released;
+};
+
+struct component_group;
+struct edge_candidates;
+
 struct multicut_problem {
-    multicut_problem() { }
+    multicut_problem()
+        : component(0), graph_hash(0), graph_weight(0), hashed_edges(0) { }
 
     explicit multicut_problem(std::shared_ptr<mutable_graph> G)
         : multicut_problem(G, std::vector<terminal>()) { }
@@ -63,7 +93,44 @@ struct multicut_problem {
                                          lower_bound(lower),
                                          upper_bound(upper),
                                          deleted_weight(deleted),
-                                         path(path) { }
+                                         path(path),
+                                         component(0),
+                                         graph_hash(0),
+                                         graph_weight(0),
+                                         hashed_edges(0) { }
+
+    // maximum length of the mapping chain before it is folded into one map
+    static constexpr size_t max_mapping_depth = 4;
+
+    // adds map from the vertices of the current graph to the vertices of
+    // the simplified graph. the maps are shared with sibling problems and
+    // never modified, so a chain longer than max_mapping_depth is folded
+    // into a new map from the original vertices. thus, mapped() only walks
+    // a constant number of maps.
+    void addMapping(std::shared_ptr<std::vector<NodeID> > map) {
+        mappings.emplace_back(map);
+        if (mappings.size() > max_mapping_depth) {
+            auto folded = std::make_shared<std::vector<NodeID> >(
+                mappings.front()->size());
+            for (NodeID n = 0; n < folded->size(); ++n) {
+                (*folded)[n] = mapped(n);
+            }
+            mappings = { folded };
+        }
+    }
+
+    // whether the data shared with the sibling can be modified in place
+    bool ownsSharedData() const {
+        return !branch || branch->released.load(std::memory_order_acquire);
+    }
+
+    // the sibling can modify the shared data in place afterwards
+    void releaseSharedData() {
+        if (branch) {
+            branch->released.store(true, std::memory_order_release);
+            branch.reset();
+        }
+    }
 
     NodeID mapped(NodeID n) const {
         NodeID n_coarse = n;
@@ -80,4 +147,30 @@ struct multicut_problem {
     FlowType                                            upper_bound;
     EdgeWeight                                          deleted_weight;
     std::string                                         path;
+    // pending modifications, graph might be shared with other problems
+    // until they are applied
+    std::vector<graph_delta>                            delta;
+    // set while the graph is shared with the sibling problem
+    std::shared_ptr<branch_token>                       branch;
+    // last isolating flow of each terminal (by original id), used to warm
+    // start the next flow computation of that terminal. queued problems
+    // only keep those of terminals with invalid flow, see
+    // branch_multicut::trimFlows
+    std::vector<std::shared_ptr<flow_snapshot> >        flows;
+    // if the problem is a component of a split problem: the split problem
+    // and the index of the component
+    std::shared_ptr<component_group>                    group;
+    size_t                                              component;
+    // zobrist key of each original vertex of the graph, see
+    // transposition_table. computed when needed if not set
+    std::shared_ptr<std::vector<uint64_t> >             zobrist;
+    // zobrist key of each vertex of the graph, hash and total edge weight
+    // of the graph. updated with the deltas, only valid while the graph
+    // has as many vertices as vertex_keys and hashed_edges edges
+    std::shared_ptr<std::vector<uint64_t> >             vertex_keys;
+    uint64_t                                            graph_hash;
+    EdgeWeight                                          graph_weight;
+    EdgeID                                              hashed_edges;
+    // branching candidates, see edge_selection.h
+    std::shared_ptr<edge_candidates>                    candidates;
 };
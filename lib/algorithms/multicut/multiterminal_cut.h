@@ -13,25 +13,38 @@
 
 #include <memory>
 #include <queue>
+#include <tuple>
 #include <vector>
 
-#include "algorithms/misc/strongly_connected_components.h"
+#include "algorithms/misc/connected_components.h"
 #include "algorithms/multicut/branch_multicut.h"
 #include "data_structure/graph_access.h"
 #include "data_structure/mutable_graph.h"
+#include "tools/graph_extractor.h"
 
 class multiterminal_cut {
  public:
     static constexpr bool debug = false;
-    multiterminal_cut() { }
+    multiterminal_cut() : timed_out(false), num_spilled(0), num_reloaded(0) { }
 
+    // returns the weight of the minimum multiterminal cut. if the time limit
+    // is reached first, timedOut() is set and the return value is invalid
     size_t multicut(std::shared_ptr<mutable_graph> G,
                     std::vector<NodeID> terminals) {
-        strongly_connected_components cc;
         auto cfg = configuration::getConfig();
         auto problems = splitConnectedComponents(G, terminals);
         FlowType flow_sum = 0;
-        for (auto& problem : problems) {
+        timed_out = false;
+        num_spilled = 0;
+        num_reloaded = 0;
+        size_t resume_component = 0;
+        if (cfg->resume) {
+            std::tie(resume_component, flow_sum) =
+                branch_multicut::readCheckpointInfo(cfg->checkpoint_file);
+        }
+
+        for (size_t c = resume_component; c < problems.size(); ++c) {
+            auto& problem = problems[c];
             if (debug) {
                 graph_algorithms::checkGraphValidity(problem.graph);
             }
@@ -42,13 +55,34 @@ class multiterminal_cut {
             }
 
             branch_multicut bmc(problem.graph, terminals);
+            bmc.setCheckpointInfo(c, flow_sum);
             auto problem_pointer = std::make_shared<multicut_problem>(problem);
             addSurroundingAreaToTerminals(problem_pointer, terminals);
-            flow_sum += bmc.find_multiterminal_cut(problem_pointer);
+            bool resume = cfg->resume && c == resume_component;
+            flow_sum += bmc.find_multiterminal_cut(problem_pointer, resume);
+            timed_out = bmc.timedOut();
+            num_spilled += bmc.numSpilled();
+            num_reloaded += bmc.numReloaded();
+            if (timed_out) {
+                break;
+            }
         }
         return flow_sum;
     }
 
+    bool timedOut() const {
+        return timed_out;
+    }
+
+    // problems spilled to disk and reloaded in the last call of multicut
+    size_t numSpilled() const {
+        return num_spilled;
+    }
+
+    size_t numReloaded() const {
+        return num_reloaded;
+    }
+
  private:
     static void addSurroundingAreaToTerminals(
         std::shared_ptr<multicut_problem> mcp,
@@ -103,46 +137,32 @@ class multiterminal_cut {
     static std::vector<multicut_problem> splitConnectedComponents(
         std::shared_ptr<mutable_graph> G, std::vector<NodeID> all_terminals) {
         std::vector<multicut_problem> problems;
-        std::vector<int> t_comp;
-        strongly_connected_components cc;
+        connected_components cc;
 
-        auto [components, num_comp] = cc.strong_components(G);
+        auto [components, num_comp] = cc.find_components(G);
         std::vector<std::vector<terminal> > terminals(num_comp);
-        std::vector<NodeID> ctr(num_comp, 0);
         std::vector<NodeID> num_terminals(num_comp, 0);
 
-        // space to create all connected components.
-        // we only actually create the components
-        // that contain at least one terminal
-        std::vector<std::shared_ptr<mutable_graph> >
-        component_subgraph(num_comp);
-
         for (NodeID t : all_terminals) {
             num_terminals[components[t]]++;
         }
 
+        // we only actually create the components
+        // that contain at least two terminals
+        std::vector<bool> extract(num_comp, false);
         for (NodeID t : all_terminals) {
-            int terminal_component = components[t];
-
-            if (num_terminals[terminal_component] == 1)
-                continue;
-
-            if (!vector::contains(t_comp, terminal_component)) {
-                graph_extractor ge;
-
-                auto [G_out, reverse_mapping] =
-                    ge.extract_block(G, terminal_component, components);
+            extract[components[t]] = (num_terminals[components[t]] > 1);
+        }
 
-                component_subgraph[terminal_component] = G_out;
+        graph_extractor ge;
+        auto [component_subgraph, new_id] =
+            ge.extract_blocks(G, components, num_comp, extract);
 
-                for (NodeID i : all_terminals) {
-                    if (components[i] == terminal_component) {
-                        terminals[terminal_component].emplace_back(
-                            reverse_mapping[i], ctr[terminal_component]++);
-                    }
-                }
+        for (NodeID t : all_terminals) {
+            int c = components[t];
+            if (extract[c]) {
+                terminals[c].emplace_back(new_id[t], terminals[c].size());
             }
-            t_comp.emplace_back(terminal_component);
         }
 
         for (size_t i = 0; i < num_comp; ++i) {
@@ -153,4 +173,8 @@ class multiterminal_cut {
 
         return problems;
     }
+
+    bool timed_out;
+    size_t num_spilled;
+    size_t num_reloaded;
 };
@@ -0,0 +1,301 @@
+/******************************************************************************
+ * disk_problem_queue.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "algorithms/multicut/multicut_problem.h"
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "tlx/logger.hpp"
+
+// Problems that were spilled to disk when the memory budget is exceeded.
+// Every problem is written to its own file in a compact binary format: the
+// graph as edge list, its pending modifications, a single map from the
+// original vertices to the vertices of that graph, the terminals and the
+// bounds. Flows for warm starts and partition indices are not stored, the
+// component group of a problem is kept in memory. Problems are reloaded in
+// order of their lower bound.
+class disk_problem_queue {
+ public:
+    typedef std::shared_ptr<multicut_problem> problemPointer;
+
+    explicit disk_problem_queue(const std::string& directory)
+        : directory(directory),
+          next_id(0),
+          num_problems(0),
+          num_reloaded(0) { }
+
+    ~disk_problem_queue() {
+        while (!index.empty()) {
+            std::remove(filename(index.top().second).c_str());
+            index.pop();
+        }
+    }
+
+    // writes problem to disk. pending modifications of the problem are
+    // stored and applied when it is solved
+    void addProblem(problemPointer problem) {
+        size_t id = next_id++;
+        std::string file = filename(id);
+        std::ofstream f(file.c_str(), std::ios::binary);
+        if (!f) {
+            LOG1 << "Error opening spill file " << file;
+            exit(1);
+        }
+        writeProblem(&f, problem);
+        f.close();
+
+        std::lock_guard<std::mutex> lck(index_mutex);
+        index.emplace(problem->lower_bound, id);
+        if (problem->group) {
+            groups.emplace(id, std::make_pair(problem->group,
+                                              problem->component));
+        }
+        num_problems++;
+    }
+
+    // reads the problem with the lowest lower bound and deletes its file,
+    // returns nullptr if there are no problems on disk
+    problemPointer pullProblem() {
+        size_t id;
+        std::pair<std::shared_ptr<component_group>, size_t> group;
+        {
+            std::lock_guard<std::mutex> lck(index_mutex);
+            if (index.empty())
+                return nullptr;
+            id = index.top().second;
+            index.pop();
+            auto it = groups.find(id);
+            if (it != groups.end()) {
+                group = it->second;
+                groups.erase(it);
+            }
+        }
+
+        std::string file = filename(id);
+        std::ifstream f(file.c_str(), std::ios::binary);
+        if (!f) {
+            LOG1 << "Error opening spill file " << file;
+            exit(1);
+        }
+        problemPointer problem = readProblem(&f);
+        std::tie(problem->group, problem->component) = group;
+        f.close();
+        std::remove(file.c_str());
+        num_problems--;
+        num_reloaded++;
+        return problem;
+    }
+
+    bool empty() {
+        return num_problems == 0;
+    }
+
+    size_t size() {
+        return num_problems;
+    }
+
+    // number of problems written to and read from disk so far
+    size_t written() const {
+        return next_id;
+    }
+
+    size_t reloaded() const {
+        return num_reloaded;
+    }
+
+    // appends all problems on disk to f, in the format of writeProblem
+    void copyProblems(std::ofstream* f) {
+        std::lock_guard<std::mutex> lck(index_mutex);
+        auto copy = index;
+        while (!copy.empty()) {
+            std::ifstream in(filename(copy.top().second).c_str(),
+                             std::ios::binary);
+            *f << in.rdbuf();
+            copy.pop();
+        }
+    }
+
+    // binary io, also used for checkpoints of branch_multicut
+    template <typename T>
+    static void write(std::ofstream* f, const T& value) {
+        f->write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    static T read(std::ifstream* f) {
+        T value;
+        f->read(reinterpret_cast<char*>(&value), sizeof(T));
+        return value;
+    }
+
+    // the graph is written as it is and not copied, so a graph shared with
+    // a sibling problem can be written together with pending modifications
+    static void writeProblem(std::ofstream* f, problemPointer problem) {
+        write(f, problem->lower_bound);
+        write(f, problem->upper_bound);
+        write(f, problem->deleted_weight);
+        write(f, problem->path.size());
+        f->write(problem->path.data(), problem->path.size());
+
+        write(f, problem->terminals.size());
+        for (const terminal& t : problem->terminals) {
+            write(f, t.original_id);
+            write(f, t.invalid_flow);
+        }
+
+        // one map from the original vertices to the vertices of the graph
+        auto G = problem->graph;
+        NodeID num_original = problem->mappings.empty()
+                              ? G->getOriginalNodes()
+                              : problem->mappings.front()->size();
+        write(f, num_original);
+        for (NodeID v = 0; v < num_original; ++v) {
+            write(f, G->getCurrentPosition(problem->mapped(v)));
+        }
+
+        // parallel edges are merged, which only needs memory for the
+        // neighborhood of a single vertex. the number of edges is known
+        // afterwards and written in front of them
+        write(f, G->n());
+        std::streampos num_edges_position = f->tellp();
+        write(f, EdgeID { 0 });
+        EdgeID num_edges = 0;
+        std::vector<std::pair<NodeID, EdgeWeight> > neighbors;
+        std::unordered_map<NodeID, size_t> index;
+        for (NodeID v : G->nodes()) {
+            for (EdgeID e : G->edges_of(v)) {
+                NodeID t = G->getEdgeTarget(v, e);
+                if (v < t) {
+                    auto [it, inserted] = index.emplace(t, neighbors.size());
+                    if (inserted) {
+                        neighbors.emplace_back(t, 0);
+                    }
+                    neighbors[it->second].second += G->getEdgeWeight(v, e);
+                }
+            }
+            for (auto [t, w] : neighbors) {
+                write(f, v);
+                write(f, t);
+                write(f, w);
+            }
+            num_edges += 2 * neighbors.size();
+            neighbors.clear();
+            index.clear();
+        }
+        std::streampos end = f->tellp();
+        f->seekp(num_edges_position);
+        write(f, num_edges);
+        f->seekp(end);
+
+        // edge indices change when the graph is rebuilt, so modifications
+        // store the edge target. they refer to the graph above, as a queued
+        // problem has at most one pending modification
+        write(f, problem->delta.size());
+        for (const graph_delta& d : problem->delta) {
+            write(f, d.op);
+            write(f, d.vertex);
+            write(f, G->getEdgeTarget(d.vertex, d.edge));
+        }
+    }
+
+    static problemPointer readProblem(std::ifstream* f) {
+        auto problem = std::make_shared<multicut_problem>();
+        problem->lower_bound = read<FlowType>(f);
+        problem->upper_bound = read<FlowType>(f);
+        problem->deleted_weight = read<EdgeWeight>(f);
+        problem->path.resize(read<size_t>(f));
+        f->read(&problem->path[0], problem->path.size());
+
+        size_t num_terminals = read<size_t>(f);
+        for (size_t i = 0; i < num_terminals; ++i) {
+            NodeID original_id = read<NodeID>(f);
+            bool invalid_flow = read<bool>(f);
+            // positions are set by graph_contraction::setTerminals
+            problem->terminals.emplace_back(0, original_id, invalid_flow);
+        }
+
+        NodeID num_original = read<NodeID>(f);
+        auto map = std::make_shared<std::vector<NodeID> >(num_original);
+        for (NodeID v = 0; v < num_original; ++v) {
+            (*map)[v] = read<NodeID>(f);
+        }
+        problem->mappings = { map };
+
+        // the graph is rebuilt with the same edges, but every adjacency
+        // array lists its lower neighbors first
+        NodeID n = read<NodeID>(f);
+        EdgeID m = read<EdgeID>(f);
+        problem->graph = std::make_shared<mutable_graph>();
+        problem->graph->start_construction(n);
+        for (EdgeID e = 0; e < m / 2; ++e) {
+            NodeID u = read<NodeID>(f);
+            NodeID v = read<NodeID>(f);
+            EdgeWeight w = read<EdgeWeight>(f);
+            problem->graph->new_edge(u, v, w);
+        }
+        problem->graph->finish_construction();
+
+        size_t num_deltas = read<size_t>(f);
+        for (size_t i = 0; i < num_deltas; ++i) {
+            auto op = read<graph_delta::operation>(f);
+            NodeID vertex = read<NodeID>(f);
+            NodeID target = read<NodeID>(f);
+            for (EdgeID e : problem->graph->edges_of(vertex)) {
+                if (problem->graph->getEdgeTarget(vertex, e) == target) {
+                    problem->delta.emplace_back(op, vertex, e);
+                    break;
+                }
+            }
+        }
+
+        if (!*f) {
+            LOG1 << "Error reading spilled problem";
+            exit(1);
+        }
+        return problem;
+    }
+
+ private:
+    std::string filename(size_t id) {
+        return directory + "/viecut_spill_" + std::to_string(getpid())
+               + "_" + std::to_string(id);
+    }
+
+    std::string directory;
+    std::atomic<size_t> next_id;
+    std::atomic<size_t> num_problems;
+    std::atomic<size_t> num_reloaded;
+    std::mutex index_mutex;
+    // (lower bound, id) of the problems on disk, lowest lower bound first
+    std::priority_queue<std::pair<FlowType, size_t>,
+                        std::vector<std::pair<FlowType, size_t> >,
+                        std::greater<std::pair<FlowType, size_t> > > index;
+    // component group and component of the problems that have one
+    std::unordered_map<size_t,
+                       std::pair<std::shared_ptr<component_group>, size_t> >
+    groups;
+};
@@ -0,0 +1,261 @@
+/******************************************************************************
+ * work_stealing_problem_queue.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "algorithms/multicut/multicut_problem.h"
+#include "common/configuration.h"
+#include "data_structure/work_stealing_deque.h"
+
+// Lock-free problem queue. Every thread owns an array of buckets, which are
+// work stealing deques. A problem is added to the bucket of its priority
+// key in the queue of the thread that created it. The owner takes problems
+// from its best non-empty bucket, idle threads steal half of the best
+// non-empty bucket of a random other thread. Thus, priorities are only
+// respected approximately: within a bucket, the owner works in LIFO order.
+class work_stealing_problem_queue {
+ public:
+    typedef std::shared_ptr<multicut_problem> problemPointer;
+    typedef work_stealing_deque<problemPointer> deque;
+
+    // 8 buckets for every power of two of the key
+    static constexpr size_t mantissa_bits = 3;
+    static constexpr size_t num_buckets = (64 - mantissa_bits + 1)
+                                          << mantissa_bits;
+
+    work_stealing_problem_queue(size_t threads, std::string pq_type)
+        : num_threads(threads) {
+        for (size_t i = 0; i < num_threads; ++i) {
+            queues.emplace_back(new local_queue(i));
+        }
+
+        larger_first = false;
+        if (pq_type == "small_graph") {
+            key = [](const problemPointer& p) {
+                      return static_cast<uint64_t>(p->graph->n());
+                  };
+        } else if (pq_type == "bound_sum") {
+            key = [](const problemPointer& p) {
+                      return bound(p->upper_bound) + bound(p->lower_bound);
+                  };
+        } else if (pq_type == "few_terminals") {
+            key = [](const problemPointer& p) {
+                      return static_cast<uint64_t>(p->terminals.size());
+                  };
+        } else if (pq_type == "upper_bound") {
+            key = [](const problemPointer& p) {
+                      return bound(p->upper_bound);
+                  };
+        } else if (pq_type == "bigger_distance") {
+            key = distance;
+            larger_first = true;
+        } else if (pq_type == "lower_distance") {
+            key = distance;
+        } else if (pq_type == "most_deleted") {
+            key = [](const problemPointer& p) {
+                      return bound(p->deleted_weight);
+                  };
+            larger_first = true;
+        } else {
+            key = [](const problemPointer& p) {
+                      return bound(p->lower_bound);
+                  };
+        }
+    }
+
+    ~work_stealing_problem_queue() {
+        for (auto& q : queues) {
+            for (auto& b : q->buckets) {
+                while (problemPointer* p = b->take()) {
+                    delete p;
+                }
+            }
+        }
+    }
+
+    // problem from the own queue or stolen from another thread. returns
+    // nullptr if none was found
+    problemPointer pullProblem(size_t local_id) {
+        local_queue& q = *queues[local_id];
+        for (size_t b = q.first_bucket; b < num_buckets; ++b) {
+            if (q.buckets[b]->empty())
+                continue;
+
+            problemPointer* p = q.buckets[b]->take();
+            if (p) {
+                q.first_bucket.store(b, std::memory_order_relaxed);
+                q.size--;
+                return unbox(p);
+            }
+        }
+        q.first_bucket.store(num_buckets, std::memory_order_relaxed);
+
+        if (num_threads == 1)
+            return nullptr;
+
+        std::uniform_int_distribution<size_t> victims(0, num_threads - 2);
+        for (size_t attempt = 0; attempt < 2 * num_threads; ++attempt) {
+            size_t victim = victims(q.rng);
+            victim += (victim >= local_id);
+            if (queues[victim]->size == 0)
+                continue;
+
+            problemPointer p = stealHalf(victim, local_id);
+            if (p)
+                return p;
+        }
+        return nullptr;
+    }
+
+    // problem with the lowest priority in the own queue, nullptr if the
+    // own queue is empty
+    problemPointer pullWorstProblem(size_t local_id) {
+        local_queue& q = *queues[local_id];
+        for (size_t b = num_buckets; b-- > q.first_bucket; ) {
+            if (q.buckets[b]->empty())
+                continue;
+
+            problemPointer* p = q.buckets[b]->take();
+            if (p) {
+                q.size--;
+                return unbox(p);
+            }
+        }
+        return nullptr;
+    }
+
+    // adds problem to the queue of thread local_id, returns local_id
+    size_t addProblem(problemPointer p, size_t local_id) {
+        local_queue& q = *queues[local_id];
+        size_t b = bucket(p);
+        // increase size first, so it never falls below 0 when the problem
+        // is stolen immediately
+        q.size++;
+        q.buckets[b]->push(new problemPointer(p));
+        if (b < q.first_bucket) {
+            q.first_bucket.store(b, std::memory_order_relaxed);
+        }
+        return local_id;
+    }
+
+    // whether there is no problem thread i can pull or steal
+    bool empty(size_t) {
+        return all_empty();
+    }
+
+    bool all_empty() {
+        return size() == 0;
+    }
+
+    size_t size() {
+        size_t s = 0;
+        for (const auto& q : queues) {
+            s += q->size;
+        }
+        return s;
+    }
+
+ private:
+    // per thread data on separate cache lines
+    struct alignas(64) local_queue {
+        explicit local_queue(size_t id)
+            : size(0), first_bucket(num_buckets), rng(id) {
+            for (size_t b = 0; b < num_buckets; ++b) {
+                buckets.emplace_back(new deque());
+            }
+        }
+
+        std::vector<std::unique_ptr<deque> > buckets;
+        std::atomic<size_t> size;
+        // no bucket before first_bucket contains a problem. only written by
+        // the owner, other threads use it as a hint
+        std::atomic<size_t> first_bucket;
+        std::mt19937 rng;
+    };
+
+    static uint64_t bound(FlowType f) {
+        return f > 0 ? static_cast<uint64_t>(f) : 0;
+    }
+
+    constexpr static auto distance = [](const problemPointer& p) {
+                                         return bound(p->upper_bound
+                                                      - p->lower_bound);
+                                     };
+
+    static problemPointer unbox(problemPointer* p) {
+        problemPointer problem = *p;
+        delete p;
+        return problem;
+    }
+
+    // keys below 2^mantissa_bits have their own bucket, larger keys share
+    // a bucket with keys that have the same highest mantissa_bits bits
+    size_t bucket(const problemPointer& p) const {
+        uint64_t k = key(p);
+        size_t b;
+        if (k < (1UL << mantissa_bits)) {
+            b = k;
+        } else {
+            size_t exponent = 63 - __builtin_clzll(k);
+            size_t mantissa = (k >> (exponent - mantissa_bits))
+                              & ((1UL << mantissa_bits) - 1);
+            b = ((exponent - mantissa_bits + 1) << mantissa_bits) + mantissa;
+        }
+        return larger_first ? num_buckets - 1 - b : b;
+    }
+
+    // steals the first problem and up to half of the remaining problems
+    // in the best non-empty bucket of victim. the additional problems are
+    // added to the same bucket of thief
+    problemPointer stealHalf(size_t victim, size_t thief) {
+        local_queue& vq = *queues[victim];
+        local_queue& tq = *queues[thief];
+        size_t first = vq.first_bucket.load(std::memory_order_relaxed);
+        for (size_t b = std::min(first, num_buckets - 1);
+             b < num_buckets; ++b) {
+            size_t available = vq.buckets[b]->size();
+            if (available == 0)
+                continue;
+
+            problemPointer* p = vq.buckets[b]->steal();
+            if (!p)
+                return nullptr;
+            vq.size--;
+
+            for (size_t i = 1; i < (available + 1) / 2; ++i) {
+                problemPointer* s = vq.buckets[b]->steal();
+                if (!s)
+                    break;
+                tq.size++;
+                vq.size--;
+                tq.buckets[b]->push(s);
+            }
+            if (b < tq.first_bucket) {
+                tq.first_bucket.store(b, std::memory_order_relaxed);
+            }
+            return unbox(p);
+        }
+        return nullptr;
+    }
+
+    size_t num_threads;
+    std::vector<std::unique_ptr<local_queue> > queues;
+    std::function<uint64_t(const problemPointer&)> key;
+    bool larger_first;
+};
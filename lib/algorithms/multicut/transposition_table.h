@@ -0,0 +1,320 @@
+/******************************************************************************
+ * transposition_table.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "algorithms/multicut/multicut_problem.h"
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+
+// Table of the graphs of the multicut problems that were already solved or
+// are currently solved. Different branch orders can reach the same graph,
+// which is then only solved again if it has a smaller deleted weight.
+//
+// Every vertex of the original graph has a random key. The zobrist key of a
+// vertex of a problem graph is the sum of the keys of the original vertices
+// it contains, so it does not depend on the order of the contractions. These
+// sums are kept for the original vertices of each problem graph and only
+// recomputed when the graph is simplified. The state of a problem is hashed
+// from the zobrist keys of its vertices and its edges with their weights.
+// The hash is a sum of vertex and edge terms, so branch_multicut updates it
+// when it applies the delta of a branch and only computes it from scratch
+// if the graph was modified otherwise, e.g. by a kernelization.
+//
+// A hit requires the same hash, number of vertices and edges, total edge
+// weight and weighted terminal degrees, so a hash collision alone does not
+// prune a problem.
+//
+// The table has buckets of 4 entries. If a bucket is full, the entry with
+// the smallest graph is replaced. Buckets are protected by striped locks.
+class transposition_table {
+ public:
+    static constexpr size_t bucket_size = 4;
+    static constexpr size_t num_locks = 1 << 12;
+
+    struct key {
+        uint64_t   hash;
+        NodeID     n;
+        EdgeID     m;
+        EdgeWeight weight;
+        uint64_t   terminals;
+    };
+
+    explicit transposition_table(size_t log_size)
+        : num_buckets(log_size > 2 ? 1UL << (log_size - 2) : 0),
+          entries(num_buckets * bucket_size),
+          locks(num_buckets ? num_locks : 0),
+          lookups(0),
+          hits(0),
+          duplicates(0) { }
+
+    bool enabled() const {
+        return num_buckets > 0;
+    }
+
+    static uint64_t mix(uint64_t x) {
+        // splitmix64 finalizer
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9UL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebUL;
+        return x ^ (x >> 31);
+    }
+
+    // random key of an original vertex
+    static uint64_t vertexKey(NodeID n) {
+        return mix(n + 0x9e3779b97f4a7c15UL);
+    }
+
+    // zobrist key of every original vertex of the problem graph, computed
+    // from the keys of the vertices of the original graph
+    static std::shared_ptr<std::vector<uint64_t> > zobristKeys(
+        const multicut_problem& problem) {
+        NodeID original_nodes = problem.mappings.empty()
+                                ? problem.graph->getOriginalNodes()
+                                : problem.mappings.front()->size();
+        auto zobrist = std::make_shared<std::vector<uint64_t> >(
+            problem.graph->getOriginalNodes(), 0);
+        for (NodeID n = 0; n < original_nodes; ++n) {
+            (*zobrist)[problem.mapped(n)] += vertexKey(n);
+        }
+        return zobrist;
+    }
+
+    // zobrist keys after the problem graph was simplified with map
+    static std::shared_ptr<std::vector<uint64_t> > simplifyKeys(
+        const std::vector<uint64_t>& zobrist,
+        const std::vector<NodeID>& map, NodeID n) {
+        auto simplified = std::make_shared<std::vector<uint64_t> >(n, 0);
+        for (NodeID v = 0; v < map.size(); ++v) {
+            (*simplified)[map[v]] += zobrist[v];
+        }
+        return simplified;
+    }
+
+    // hash of an edge between vertices with the zobrist keys a and b
+    static uint64_t edgeKey(uint64_t a, uint64_t b, EdgeWeight w) {
+        if (a > b) {
+            std::swap(a, b);
+        }
+        return mix(mix(a) ^ (b + w));
+    }
+
+    // computes the zobrist key of every vertex and the hash of the problem
+    // graph from scratch, in O(original vertices + n + m)
+    static void hashGraph(multicut_problem* problem) {
+        if (!problem->zobrist) {
+            problem->zobrist = zobristKeys(*problem);
+        }
+
+        auto G = problem->graph;
+        const std::vector<uint64_t>& zobrist = *problem->zobrist;
+        auto keys = std::make_shared<std::vector<uint64_t> >(
+            G->number_of_nodes(), 0);
+        for (NodeID u = 0; u < G->getOriginalNodes(); ++u) {
+            (*keys)[G->getCurrentPosition(u)] += zobrist[u];
+        }
+
+        problem->vertex_keys = keys;
+        problem->graph_hash = 0;
+        problem->graph_weight = 0;
+        problem->hashed_edges = 0;
+        for (NodeID v : G->nodes()) {
+            problem->graph_hash += mix((*keys)[v]);
+            for (EdgeID e : G->edges_of(v)) {
+                NodeID t = G->getEdgeTarget(v, e);
+                if (v < t) {
+                    hashEdge(problem, v, e, 1);
+                }
+            }
+        }
+    }
+
+    // whether vertex_keys and graph_hash belong to the current graph. the
+    // graph is only modified by deletions and contractions, so a modified
+    // graph has fewer vertices or edges
+    static bool hasGraphHash(const multicut_problem& problem) {
+        return problem.vertex_keys
+               && problem.vertex_keys->size() == problem.graph->n()
+               && problem.hashed_edges == problem.graph->m();
+    }
+
+    // has to be called before edge e of v is deleted
+    static void deleteEdge(multicut_problem* problem, NodeID v, EdgeID e) {
+        hashEdge(problem, v, e, -1);
+    }
+
+    // has to be called before edge e of v is contracted, removes both
+    // vertices and their edges from the hash
+    static void removeEndpoints(multicut_problem* problem,
+                                NodeID v, EdgeID e) {
+        auto G = problem->graph;
+        NodeID t = G->getEdgeTarget(v, e);
+        hashVertex(problem, v, UNDEFINED_NODE, -1);
+        hashVertex(problem, t, v, -1);
+    }
+
+    // has to be called after the contraction of an edge between kept and
+    // removed. the last vertex was moved to the position of removed
+    static void mergeEndpoints(multicut_problem* problem,
+                               NodeID kept, NodeID removed) {
+        std::vector<uint64_t>& keys = *problem->vertex_keys;
+        keys[kept] += keys[removed];
+        keys[removed] = keys.back();
+        keys.pop_back();
+    }
+
+    // adds vertex v and its edges to the hash
+    static void addVertex(multicut_problem* problem, NodeID v) {
+        hashVertex(problem, v, UNDEFINED_NODE, 1);
+    }
+
+    // key of the problem graph. salt distinguishes problems whose bounds
+    // are on different scales, i.e. the components of split problems.
+    // as the hash can collide, the key also contains the exact total edge
+    // weight and the weighted degrees of the terminals
+    static key stateKey(multicut_problem* problem, uint64_t salt) {
+        if (!hasGraphHash(*problem)) {
+            hashGraph(problem);
+        }
+
+        auto G = problem->graph;
+        std::vector<std::pair<NodeID, EdgeWeight> > degrees;
+        for (const auto& t : problem->terminals) {
+            degrees.emplace_back(t.original_id,
+                                 G->getWeightedNodeDegree(t.position));
+        }
+        std::sort(degrees.begin(), degrees.end());
+
+        uint64_t signature = degrees.size();
+        for (const auto& [id, degree] : degrees) {
+            signature = mix(signature ^ vertexKey(id)) + degree;
+        }
+
+        return key { problem->graph_hash + mix(salt), G->number_of_nodes(),
+                     G->number_of_edges(), problem->graph_weight,
+                     signature };
+    }
+
+    // returns true if a problem with the same graph and at most the same
+    // deleted weight was added before. otherwise, the problem is added and
+    // lower is set to the best known lower bound of the multicut in the
+    // graph (without the deleted weight)
+    bool visit(const key& k, EdgeWeight deleted, FlowType* lower) {
+        *lower = 0;
+        lookups++;
+        size_t b = bucket(k);
+        std::lock_guard<std::mutex> lck(locks[b % num_locks]);
+        entry* replace = &entries[b * bucket_size];
+        for (size_t i = 0; i < bucket_size; ++i) {
+            entry& e = entries[b * bucket_size + i];
+            if (e.matches(k)) {
+                hits++;
+                if (e.deleted <= deleted) {
+                    duplicates++;
+                    return true;
+                }
+                e.deleted = deleted;
+                *lower = e.lower;
+                return false;
+            }
+            if (e.n < replace->n) {
+                replace = &e;
+            }
+        }
+
+        *replace = entry { k.hash, k.n, k.m, k.weight, k.terminals,
+                           deleted, 0 };
+        return false;
+    }
+
+    // the multicut in the graph of k is at least lower
+    void setLowerBound(const key& k, FlowType lower) {
+        size_t b = bucket(k);
+        std::lock_guard<std::mutex> lck(locks[b % num_locks]);
+        for (size_t i = 0; i < bucket_size; ++i) {
+            entry& e = entries[b * bucket_size + i];
+            if (e.matches(k) && lower > e.lower) {
+                e.lower = lower;
+            }
+        }
+    }
+
+    size_t numLookups() const {
+        return lookups;
+    }
+
+    size_t numHits() const {
+        return hits;
+    }
+
+    size_t numDuplicates() const {
+        return duplicates;
+    }
+
+ private:
+    struct entry {
+        bool matches(const key& k) const {
+            return hash == k.hash && n == k.n && m == k.m
+                   && weight == k.weight && terminals == k.terminals;
+        }
+
+        uint64_t   hash;
+        // empty entries have n = 0, no problem graph is empty
+        NodeID     n;
+        EdgeID     m;
+        EdgeWeight weight;
+        uint64_t   terminals;
+        EdgeWeight deleted;
+        FlowType   lower;
+    };
+
+    // adds (sign = 1) or removes (sign = -1) edge e of v
+    static void hashEdge(multicut_problem* problem, NodeID v, EdgeID e,
+                         int sign) {
+        auto G = problem->graph;
+        const std::vector<uint64_t>& keys = *problem->vertex_keys;
+        EdgeWeight w = G->getEdgeWeight(v, e);
+        uint64_t edge = edgeKey(keys[v], keys[G->getEdgeTarget(v, e)], w);
+        problem->graph_hash += sign * edge;
+        problem->graph_weight += sign * w;
+        // m() counts both directions of an edge
+        problem->hashed_edges += 2 * sign;
+    }
+
+    // adds or removes vertex v and its edges, except the edges to skip
+    static void hashVertex(multicut_problem* problem, NodeID v, NodeID skip,
+                           int sign) {
+        auto G = problem->graph;
+        problem->graph_hash += sign * mix((*problem->vertex_keys)[v]);
+        for (EdgeID e : G->edges_of(v)) {
+            if (G->getEdgeTarget(v, e) != skip) {
+                hashEdge(problem, v, e, sign);
+            }
+        }
+    }
+
+    size_t bucket(const key& k) const {
+        return k.hash & (num_buckets - 1);
+    }
+
+    size_t num_buckets;
+    std::vector<entry> entries;
+    std::vector<std::mutex> locks;
+    std::atomic<size_t> lookups;
+    std::atomic<size_t> hits;
+    std::atomic<size_t> duplicates;
+};
@@ -14,7 +14,6 @@
 #include <cstdint>
 #include <cstdlib>
 #include <memory>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -179,9 +178,8 @@ class contraction {
     static std::shared_ptr<mutable_graph> fromUnionFind(
         std::shared_ptr<mutable_graph> G,
         union_find* uf) {
-        std::vector<std::vector<NodeID> > reverse_mapping(uf->n());
-
         std::vector<NodeID> part(G->number_of_nodes(), UNDEFINED_NODE);
+        std::vector<NodeID> mapping(G->number_of_nodes());
         NodeID current_pid = 0;
 
         for (NodeID n : G->nodes()) {
@@ -191,19 +189,11 @@ class contraction {
                 part[part_id] = current_pid++;
             }
 
-            reverse_mapping[part[part_id]].push_back(
-                G->containedVertices(n)[0]);
+            mapping[n] = part[part_id];
         }
 
-        for (size_t i = 0; i < reverse_mapping.size(); ++i) {
-            if (reverse_mapping[i].size() > 1) {
-                std::unordered_set<NodeID> vtx_to_ctr;
-                for (auto v : reverse_mapping[i]) {
-                    vtx_to_ctr.emplace(G->getCurrentPosition(v));
-                }
-
-                G->contractVertexSet(vtx_to_ctr);
-            }
+        if (current_pid < G->number_of_nodes()) {
+            G->contractPartition(mapping, current_pid);
         }
 
         if (debug) {
@@ -44,6 +44,25 @@ class configuration {
     size_t preset_percentage = 0;
     size_t total_terminals = 0;
     bool noBranching = false;
+    // compute all isolating cuts with O(log k) flows instead of k flows
+    bool use_isolating_cuts = false;
+    // above this heap size (in GB), problems are spilled to spill_path
+    size_t memory_budget = 250;
+    std::string spill_path = "/tmp";
+    // search state is written to checkpoint_file every checkpoint_interval
+    // seconds and when time_limit is reached. subproblems are not split
+    // into connected components if it is set
+    std::string checkpoint_file = "";
+    double checkpoint_interval = 600.0;
+    double time_limit = 3600.0;
+    bool resume = false;
+    // log2 of the number of entries of the transposition table of
+    // multicut problems, 0 disables it
+    size_t transposition_log_size = 20;
+    // iterations of the primal heuristic, 0 disables it. the heuristic
+    // runs on open problems at most every heuristic_interval seconds
+    size_t heuristic_iterations = 20;
+    double heuristic_interval = 1.0;
     size_t print_cc = 0;
 
     // minimum cut parameters
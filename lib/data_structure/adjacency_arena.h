@@ -0,0 +1,318 @@
+/******************************************************************************
+ * adjacency_arena.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "common/definitions.h"
+#include "tools/vector.h"
+
+// Adjacency lists of all vertices stored in a single contiguous slab.
+// Every vertex owns a segment [begin, begin + capacity) of the slab, of which
+// the first 'size' entries are in use. A vertex that outgrows its segment is
+// relocated to the end of the slab with twice the capacity. Abandoned
+// segments are reclaimed by compaction once they make up half of the slab.
+//
+// Copying the arena copies two flat arrays instead of one array per vertex.
+// References and pointers to edges are invalidated by any operation that
+// adds edges or vertices.
+template <typename Edge>
+class adjacency_arena {
+ public:
+    // view on the adjacency list of a single vertex with the interface of the
+    // std::vector it replaces. only valid as long as the arena exists.
+    class segment_ref {
+     public:
+        segment_ref(adjacency_arena* p_arena, NodeID p_node)
+            : arena(p_arena), node(p_node) { }
+
+        Edge& operator[](EdgeID e) {
+            return arena->m_edges[arena->m_segments[node].begin + e];
+        }
+
+        EdgeID size() const {
+            return arena->m_segments[node].size;
+        }
+
+        Edge* begin() {
+            return arena->m_edges.data() + arena->m_segments[node].begin;
+        }
+
+        Edge* end() {
+            return begin() + size();
+        }
+
+        template <typename... Args>
+        void emplace_back(Args&& ... args) {
+            arena->push_back(node, Edge(std::forward<Args>(args) ...));
+        }
+
+        void pop_back() {
+            --arena->m_segments[node].size;
+        }
+
+        void resize(EdgeID new_size) {
+            arena->resize(node, new_size);
+        }
+
+     private:
+        adjacency_arena* arena;
+        NodeID node;
+    };
+
+    class const_segment_ref {
+     public:
+        const_segment_ref(const adjacency_arena* p_arena, NodeID p_node)
+            : arena(p_arena), node(p_node) { }
+
+        const Edge& operator[](EdgeID e) const {
+            return arena->m_edges[arena->m_segments[node].begin + e];
+        }
+
+        EdgeID size() const {
+            return arena->m_segments[node].size;
+        }
+
+        const Edge* begin() const {
+            return arena->m_edges.data() + arena->m_segments[node].begin;
+        }
+
+        const Edge* end() const {
+            return begin() + size();
+        }
+
+     private:
+        const adjacency_arena* arena;
+        NodeID node;
+    };
+
+    adjacency_arena() : m_num_nodes(0), m_used(0), m_garbage(0) { }
+
+    adjacency_arena(const adjacency_arena& copy) {
+        *this = copy;
+    }
+
+    adjacency_arena(adjacency_arena&& other) = default;
+    adjacency_arena& operator = (adjacency_arena&& other) = default;
+
+    // copies the used part of the slab as a whole,
+    // unless most of it is abandoned segments
+    adjacency_arena& operator = (const adjacency_arena& copy) {
+        if (this == &copy)
+            return *this;
+
+        m_segments = copy.m_segments;
+        m_num_nodes = copy.m_num_nodes;
+        if (2 * copy.m_garbage > copy.m_used) {
+            m_edges.clear();
+            compactFrom(copy.m_edges);
+        } else {
+            m_edges.assign(copy.m_edges.begin(),
+                           copy.m_edges.begin() + copy.m_used);
+            m_used = copy.m_used;
+            m_garbage = copy.m_garbage;
+        }
+        return *this;
+    }
+
+    segment_ref operator[](NodeID node) {
+        return segment_ref(this, node);
+    }
+
+    const_segment_ref operator[](NodeID node) const {
+        return const_segment_ref(this, node);
+    }
+
+    NodeID size() const {
+        return m_num_nodes;
+    }
+
+    EdgeID degree(NodeID node) const {
+        return m_segments[node].size;
+    }
+
+    // vertices added by resize or emplace_back have no edges.
+    // removed vertices keep an empty segment, so that their degree
+    // can still be read as 0
+    void resize(NodeID n) {
+        while (m_num_nodes > n) {
+            pop_back();
+        }
+        if (m_segments.size() < n) {
+            m_segments.resize(n, segment());
+        }
+        m_num_nodes = n;
+    }
+
+    void emplace_back() {
+        resize(m_num_nodes + 1);
+    }
+
+    void pop_back() {
+        release(m_segments[m_num_nodes - 1]);
+        m_segments[m_num_nodes - 1] = segment();
+        --m_num_nodes;
+    }
+
+    // gives the adjacency list of 'from' to 'to', 'from' is empty afterwards
+    void move_vertex(NodeID to, NodeID from) {
+        if (to == from)
+            return;
+
+        release(m_segments[to]);
+        m_segments[to] = m_segments[from];
+        m_segments[from] = segment();
+    }
+
+    // replaces the adjacency list of 'node' by 'edges'
+    void assign(NodeID node, const std::vector<Edge>& edges) {
+        m_segments[node].size = 0;
+        reserve(node, edges.size());
+        std::copy(edges.begin(), edges.end(),
+                  m_edges.begin() + m_segments[node].begin);
+        m_segments[node].size = edges.size();
+    }
+
+    // edge is taken by value, as it might be a reference into the slab
+    void push_back(NodeID node, Edge edge) {
+        segment& s = m_segments[node];
+        if (s.size == s.capacity) {
+            reserve(node, std::max(static_cast<EdgeID>(4), 2 * s.capacity));
+        }
+        m_edges[m_segments[node].begin + m_segments[node].size++] = edge;
+    }
+
+    void resize(NodeID node, EdgeID new_size) {
+        reserve(node, new_size);
+        m_segments[node].size = new_size;
+    }
+
+    // lays out all vertices back to back with the given degrees, edges can
+    // afterwards be written in parallel. existing edges are discarded.
+    void allocate(const std::vector<EdgeID>& degrees, bool parallel = true) {
+        std::vector<EdgeID> begin(degrees.size() + 1, 0);
+#pragma omp parallel for schedule(static) if (parallel)
+        for (NodeID n = 0; n < degrees.size(); ++n) {
+            begin[n] = degrees[n];
+        }
+        EdgeID total = vector::prefix_sum(&begin, parallel);
+
+        m_edges.clear();
+        m_edges.resize(total);
+        m_segments.assign(degrees.size(), segment());
+        m_num_nodes = degrees.size();
+#pragma omp parallel for schedule(static) if (parallel)
+        for (NodeID n = 0; n < degrees.size(); ++n) {
+            m_segments[n] = segment(begin[n], degrees[n], degrees[n]);
+        }
+        m_used = total;
+        m_garbage = 0;
+    }
+
+    // moves all segments to the front of the slab without slack
+    void compact() {
+        std::vector<Edge> edges;
+        edges.swap(m_edges);
+        compactFrom(edges);
+    }
+
+ private:
+    struct segment {
+        segment() : begin(0), size(0), capacity(0) { }
+
+        segment(EdgeID p_begin, EdgeID p_size, EdgeID p_capacity)
+            : begin(p_begin), size(p_size), capacity(p_capacity) { }
+
+        EdgeID begin;
+        EdgeID size;
+        EdgeID capacity;
+    };
+
+    // makes sure that the segment of 'node' can hold 'capacity' edges
+    void reserve(NodeID node, EdgeID capacity) {
+        segment& s = m_segments[node];
+        if (capacity <= s.capacity)
+            return;
+
+        if (s.capacity > 0 && s.begin + s.capacity == m_used) {
+            // last segment in the slab grows in place
+            growSlab(s.begin + capacity);
+            m_used = s.begin + capacity;
+            s.capacity = capacity;
+            return;
+        }
+
+        if (m_garbage > minimum_garbage && 2 * m_garbage > m_used) {
+            compact();
+            reserve(node, capacity);
+            return;
+        }
+
+        EdgeID begin = m_used;
+        growSlab(begin + capacity);
+        std::copy(m_edges.begin() + s.begin,
+                  m_edges.begin() + s.begin + s.size,
+                  m_edges.begin() + begin);
+        m_garbage += s.capacity;
+        s.begin = begin;
+        s.capacity = capacity;
+        m_used = begin + capacity;
+    }
+
+    // writes the segments back to back into m_edges, reading the
+    // edges from 'edges' at the current segment positions
+    void compactFrom(const std::vector<Edge>& edges) {
+        EdgeID total = 0;
+        for (const segment& s : m_segments) {
+            total += s.size;
+        }
+
+        m_edges.resize(total);
+        EdgeID pos = 0;
+        for (segment& s : m_segments) {
+            std::copy(edges.begin() + s.begin,
+                      edges.begin() + s.begin + s.size,
+                      m_edges.begin() + pos);
+            s = segment(pos, s.size, s.size);
+            pos += s.size;
+        }
+        m_used = pos;
+        m_garbage = 0;
+    }
+
+    void growSlab(EdgeID size) {
+        if (size > m_edges.size()) {
+            m_edges.resize(std::max(size, 2 * m_edges.size()));
+        }
+    }
+
+    void release(const segment& s) {
+        if (s.capacity > 0 && s.begin + s.capacity == m_used) {
+            m_used = s.begin;
+        } else {
+            m_garbage += s.capacity;
+        }
+    }
+
+    // small slabs are not compacted, as relocating is cheap
+    static constexpr EdgeID minimum_garbage = 1024;
+
+    std::vector<Edge> m_edges;
+    std::vector<segment> m_segments;
+    NodeID m_num_nodes;
+    EdgeID m_used;
+    EdgeID m_garbage;
+};
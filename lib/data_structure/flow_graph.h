@@ -14,136 +14,179 @@
 
 #pragma once
 
+#include <omp.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include "common/definitions.h"
 #include "data_structure/graph_access.h"
+#include "tools/vector.h"
 
-struct rEdge {
-    NodeID   source;
-    NodeID   target;
-    FlowType capacity;
-    FlowType flow;
-    EdgeID   reverse_edge_index;
-
-    rEdge(NodeID source, NodeID target, FlowType capacity,
-          FlowType flow, EdgeID reverse_edge_index) {
-        this->source = source;
-        this->target = target;
-        this->capacity = capacity;
-        this->flow = flow;
-        this->reverse_edge_index = reverse_edge_index;
-    }
-};
-
-// this is a adjacency list implementation of the residual graph
+// this is a CSR implementation of the residual graph
 // for each edge we create, we create a rev edge with cap 0
 // zero capacity edges are residual edges
+//
+// targets, capacities, flows and reverse edges are stored in separate
+// arrays. edges are addressed by their vertex and their index in the
+// adjacency of that vertex.
 class flow_graph {
  public:
-    flow_graph() {
-        m_num_edges = 0;
-        m_num_nodes = 0;
+    flow_graph() : m_first_edge(1, 0), m_num_nodes(0), m_num_edges(0) { }
+
+    // residual graph of G, built in parallel. the adjacency of vertex v lists
+    // the reverse edges of edges from lower vertices first, then the edges
+    // of v and then the reverse edges of edges from higher vertices.
+    explicit flow_graph(std::shared_ptr<graph_access> G)
+        : m_num_nodes(G->number_of_nodes()),
+          m_num_edges(2 * G->number_of_edges()) {
+        NodeID n = m_num_nodes;
+
+        // in-edges of every vertex, ordered by edge ID
+        std::vector<EdgeID> in_offset(n + 1, 0);
+        std::vector<EdgeID> lower_in(n, 0);
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (NodeID u = 0; u < n; ++u) {
+            for (EdgeID e : G->edges_of(u)) {
+                NodeID v = G->getEdgeTarget(e);
+                __sync_fetch_and_add(&in_offset[v], 1);
+                if (u < v) {
+                    __sync_fetch_and_add(&lower_in[v], 1);
+                }
+            }
+        }
+
+        m_first_edge.resize(n + 1);
+#pragma omp parallel for schedule(static)
+        for (NodeID v = 0; v < n; ++v) {
+            m_first_edge[v] = in_offset[v] + G->getNodeDegree(v);
+        }
+        m_first_edge[n] = 0;
+        vector::prefix_sum(&in_offset);
+        vector::prefix_sum(&m_first_edge);
+
+        std::vector<std::pair<EdgeID, NodeID> > in_edges(in_offset[n]);
+        std::vector<EdgeID> next_in(in_offset.begin(), in_offset.end() - 1);
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (NodeID u = 0; u < n; ++u) {
+            for (EdgeID e : G->edges_of(u)) {
+                NodeID v = G->getEdgeTarget(e);
+                EdgeID pos = __sync_fetch_and_add(&next_in[v], 1);
+                in_edges[pos] = std::make_pair(e, u);
+            }
+        }
+
+        m_target.resize(m_num_edges);
+        m_capacity.resize(m_num_edges);
+        m_flow.resize(m_num_edges, 0);
+        m_reverse_edge.resize(m_num_edges);
+        m_node_capacity.resize(n);
+
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (NodeID v = 0; v < n; ++v) {
+            FlowType node_capacity = 0;
+            EdgeID forward = m_first_edge[v] + lower_in[v];
+            for (EdgeID e : G->edges_of(v)) {
+                EdgeID pos = forward + (e - G->get_first_edge(v));
+                m_target[pos] = G->getEdgeTarget(e);
+                m_capacity[pos] = G->getEdgeWeight(e);
+                node_capacity += G->getEdgeWeight(e);
+            }
+            m_node_capacity[v] = node_capacity;
+
+            std::sort(in_edges.begin() + in_offset[v],
+                      in_edges.begin() + in_offset[v + 1]);
+            for (EdgeID r = 0; r < in_offset[v + 1] - in_offset[v]; ++r) {
+                auto [e, u] = in_edges[in_offset[v] + r];
+                EdgeID local = (r < lower_in[v]) ? r : r + G->getNodeDegree(v);
+                // the edge of u is at the same position as its reverse edge
+                // in the adjacency of v before the edges of v
+                EdgeID rev = lower_in[u] + (e - G->get_first_edge(u));
+                m_target[m_first_edge[v] + local] = u;
+                m_capacity[m_first_edge[v] + local] = 0;
+                m_reverse_edge[m_first_edge[v] + local] = rev;
+                m_reverse_edge[m_first_edge[u] + rev] = local;
+            }
+        }
     }
 
     virtual ~flow_graph() { }
 
-    void start_construction(NodeID nodes, EdgeID edges = 0) {
-        m_adjacency_lists.resize(nodes);
-        m_capacity.resize(nodes);
-        m_num_nodes = nodes;
-        m_num_edges = edges;
-    }
-
-    void finish_construction() { }
-
     NodeID number_of_nodes() const { return m_num_nodes; }
-    EdgeID number_of_edges() { return m_num_edges; }
+    EdgeID number_of_edges() const { return m_num_edges; }
 
-    NodeID getEdgeTarget(NodeID source, EdgeID e);
+    NodeID getEdgeTarget(NodeID source, EdgeID e) const;
     FlowType getEdgeCapacity(NodeID source, EdgeID e) const;
 
-    FlowType getEdgeFlow(NodeID source, EdgeID e);
+    FlowType getEdgeFlow(NodeID source, EdgeID e) const;
     void setEdgeFlow(NodeID source, EdgeID e, FlowType flow);
 
-    EdgeID getReverseEdge(NodeID source, EdgeID e);
-
-    void new_edge(NodeID source, NodeID target, FlowType capacity) {
-        m_adjacency_lists[source].push_back(
-            rEdge(source, target, capacity, 0,
-                  m_adjacency_lists[target].size()));
-        // for each edge we add a reverse edge
-        m_adjacency_lists[target].push_back(
-            rEdge(target, source, 0, 0, m_adjacency_lists[source].size() - 1));
-        m_capacity[source] += capacity;
-        m_num_edges += 2;
+    EdgeID getReverseEdge(NodeID source, EdgeID e) const;
+
+    // sets the flow on all edges to 0
+    void resetFlow() {
+#pragma omp parallel for schedule(static)
+        for (EdgeID e = 0; e < m_num_edges; ++e) {
+            m_flow[e] = 0;
+        }
     }
 
     FlowType getCapacity(NodeID node) const {
-        return m_capacity[node];
+        return m_node_capacity[node];
     }
 
-    EdgeID get_first_edge(NodeID /* node */) { return 0; }
-    EdgeID get_first_invalid_edge(NodeID node) {
-        return m_adjacency_lists[node].size();
+    EdgeID get_first_edge(NodeID /* node */) const { return 0; }
+    EdgeID get_first_invalid_edge(NodeID node) const {
+        return m_first_edge[node + 1] - m_first_edge[node];
     }
 
-    auto nodes() {
+    auto nodes() const {
         return iterator<NodeID>(0, number_of_nodes());
     }
 
-    auto edges_of(NodeID n) {
+    auto edges_of(NodeID n) const {
         return iterator<EdgeID>(get_first_edge(n), get_first_invalid_edge(n));
     }
 
  private:
-    std::vector<std::vector<rEdge> > m_adjacency_lists;
+    EdgeID index(NodeID source, EdgeID e) const {
+        VIECUT_ASSERT_LT(e, get_first_invalid_edge(source));
+        return m_first_edge[source] + e;
+    }
+
+    std::vector<EdgeID> m_first_edge;
+    std::vector<NodeID> m_target;
     std::vector<FlowType> m_capacity;
+    std::vector<FlowType> m_flow;
+    std::vector<EdgeID> m_reverse_edge;
+    std::vector<FlowType> m_node_capacity;
     NodeID m_num_nodes;
-    NodeID m_num_edges;
+    EdgeID m_num_edges;
 };
 
 inline
 FlowType flow_graph::getEdgeCapacity(NodeID source, EdgeID e) const {
-#ifdef NDEBUG
-    return m_adjacency_lists[source][e].capacity;
-#else
-    return m_adjacency_lists.at(source).at(e).capacity;
-#endif
+    return m_capacity[index(source, e)];
 }
 
 inline
 void flow_graph::setEdgeFlow(NodeID source, EdgeID e, FlowType flow) {
-#ifdef NDEBUG
-    m_adjacency_lists[source][e].flow = flow;
-#else
-    m_adjacency_lists.at(source).at(e).flow = flow;
-#endif
+    m_flow[index(source, e)] = flow;
 }
 
 inline
-FlowType flow_graph::getEdgeFlow(NodeID source, EdgeID e) {
-#ifdef NDEBUG
-    return m_adjacency_lists[source][e].flow;
-#else
-    return m_adjacency_lists.at(source).at(e).flow;
-#endif
+FlowType flow_graph::getEdgeFlow(NodeID source, EdgeID e) const {
+    return m_flow[index(source, e)];
 }
 
 inline
-NodeID flow_graph::getEdgeTarget(NodeID source, EdgeID e) {
-#ifdef NDEBUG
-    return m_adjacency_lists[source][e].target;
-#else
-    return m_adjacency_lists.at(source).at(e).target;
-#endif
+NodeID flow_graph::getEdgeTarget(NodeID source, EdgeID e) const {
+    return m_target[index(source, e)];
 }
 
 inline
-EdgeID flow_graph::getReverseEdge(NodeID source, EdgeID e) {
-#ifdef NDEBUG
-    return m_adjacency_lists[source][e].reverse_edge_index;
-#else
-    return m_adjacency_lists.at(source).at(e).reverse_edge_index;
-#endif
+EdgeID flow_graph::getReverseEdge(NodeID source, EdgeID e) const {
+    return m_reverse_edge[index(source, e)];
 }
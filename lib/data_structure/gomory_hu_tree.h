@@ -0,0 +1,173 @@
+/******************************************************************************
+ * gomory_hu_tree.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/definitions.h"
+#include "tlx/logger.hpp"
+
+// Gomory-Hu tree stored as parent array rooted at vertex 0. The edge from v
+// to its parent has the weight of a minimum cut between v and its parent.
+// The minimum cut between two vertices u and v is the lightest edge on the
+// tree path between them, which is found in O(log n) using jump pointers
+// that store the minimum weight on the jumped over path.
+class gomory_hu_tree {
+ public:
+    gomory_hu_tree() { }
+
+    gomory_hu_tree(const std::vector<NodeID>& parent,
+                   const std::vector<EdgeWeight>& weight)
+        : m_parent(parent), m_weight(weight) {
+        buildJumpPointers();
+    }
+
+    NodeID number_of_nodes() const {
+        return m_parent.size();
+    }
+
+    NodeID getParent(NodeID v) const {
+        return m_parent[v];
+    }
+
+    EdgeWeight getParentWeight(NodeID v) const {
+        return m_weight[v];
+    }
+
+    // weight of a minimum cut between u and v, max() for u == v
+    EdgeWeight connectivity(NodeID u, NodeID v) const {
+        EdgeWeight min_weight = std::numeric_limits<EdgeWeight>::max();
+        if (m_depth[u] < m_depth[v]) {
+            std::swap(u, v);
+        }
+
+        NodeID diff = m_depth[u] - m_depth[v];
+        for (size_t l = 0; diff > 0; ++l, diff >>= 1) {
+            if (diff & 1) {
+                min_weight = std::min(min_weight, m_jump_min[l][u]);
+                u = m_jump[l][u];
+            }
+        }
+
+        if (u == v)
+            return min_weight;
+
+        for (size_t l = m_jump.size(); l-- > 0; ) {
+            if (m_jump[l][u] != m_jump[l][v]) {
+                min_weight = std::min(min_weight, m_jump_min[l][u]);
+                min_weight = std::min(min_weight, m_jump_min[l][v]);
+                u = m_jump[l][u];
+                v = m_jump[l][v];
+            }
+        }
+
+        return std::min(min_weight, std::min(m_weight[u], m_weight[v]));
+    }
+
+    // one line per vertex: parent and weight of the edge to the parent
+    void writeTree(const std::string& filename) const {
+        std::ofstream f(filename.c_str());
+        f << number_of_nodes() << std::endl;
+        for (NodeID v = 0; v < number_of_nodes(); ++v) {
+            f << m_parent[v] << " " << m_weight[v] << std::endl;
+        }
+        f.close();
+    }
+
+    static std::shared_ptr<gomory_hu_tree> readTree(
+        const std::string& filename) {
+        std::ifstream f(filename.c_str());
+        if (!f) {
+            LOG1 << "Error opening file " << filename;
+            exit(1);
+        }
+
+        NodeID n = 0;
+        f >> n;
+        std::vector<NodeID> parent(n);
+        std::vector<EdgeWeight> weight(n);
+        for (NodeID v = 0; v < n; ++v) {
+            f >> parent[v] >> weight[v];
+        }
+        return std::make_shared<gomory_hu_tree>(parent, weight);
+    }
+
+ private:
+    void buildJumpPointers() {
+        NodeID n = number_of_nodes();
+        m_depth.assign(n, 0);
+        if (n == 0)
+            return;
+
+        // parents are not necessarily smaller than their children,
+        // so depths are computed in bfs order from the root
+        std::vector<NodeID> first_child(n + 1, 0);
+        for (NodeID v = 1; v < n; ++v) {
+            first_child[m_parent[v] + 1]++;
+        }
+        for (NodeID v = 0; v < n; ++v) {
+            first_child[v + 1] += first_child[v];
+        }
+        std::vector<NodeID> children(n > 0 ? n - 1 : 0);
+        std::vector<NodeID> next_child(first_child.begin(),
+                                       first_child.end() - 1);
+        for (NodeID v = 1; v < n; ++v) {
+            children[next_child[m_parent[v]]++] = v;
+        }
+
+        std::vector<NodeID> order = { 0 };
+        for (size_t i = 0; i < order.size(); ++i) {
+            NodeID v = order[i];
+            for (NodeID c = first_child[v]; c < first_child[v + 1]; ++c) {
+                m_depth[children[c]] = m_depth[v] + 1;
+                order.emplace_back(children[c]);
+            }
+        }
+
+        NodeID max_depth = *std::max_element(m_depth.begin(), m_depth.end());
+        size_t levels = 1;
+        while ((static_cast<NodeID>(1) << levels) <= max_depth) {
+            levels++;
+        }
+
+        m_jump.assign(levels, std::vector<NodeID>(n));
+        m_jump_min.assign(levels, std::vector<EdgeWeight>(n));
+        for (NodeID v = 0; v < n; ++v) {
+            m_jump[0][v] = m_parent[v];
+            m_jump_min[0][v] = m_weight[v];
+        }
+        m_jump[0][0] = 0;
+        m_jump_min[0][0] = std::numeric_limits<EdgeWeight>::max();
+
+        for (size_t l = 1; l < levels; ++l) {
+            for (NodeID v = 0; v < n; ++v) {
+                NodeID mid = m_jump[l - 1][v];
+                m_jump[l][v] = m_jump[l - 1][mid];
+                m_jump_min[l][v] = std::min(m_jump_min[l - 1][v],
+                                            m_jump_min[l - 1][mid]);
+            }
+        }
+    }
+
+    std::vector<NodeID> m_parent;
+    std::vector<EdgeWeight> m_weight;
+    std::vector<NodeID> m_depth;
+    // m_jump[l][v] is the ancestor 2^l levels above v
+    std::vector<std::vector<NodeID> > m_jump;
+    std::vector<std::vector<EdgeWeight> > m_jump_min;
+};
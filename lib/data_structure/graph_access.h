@@ -543,6 +543,16 @@ class graph_access {
 #endif
     }
 
+    // only to be used when building a graph after resize_m, where
+    // edges are written directly to their position in the edge array
+    void setEdgeTarget(EdgeID edge, NodeID target) {
+#ifdef NDEBUG
+        graphref->m_edges[edge].target = target;
+#else
+        graphref->m_edges.at(edge).target = target;
+#endif
+    }
+
     EdgeID find_reverse_edge(EdgeID e) {
         EdgeID e_rev = -1;
         NodeID src = getEdgeSource(e);
@@ -11,51 +11,67 @@
 
 #pragma once
 
+#include <omp.h>
+
 #include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <tuple>
-#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "common/definitions.h"
+#include "data_structure/adjacency_arena.h"
 #include "data_structure/graph_access.h"
 #include "tlx/logger.hpp"
+#include "tools/vector.h"
+
+// with SMALL_EDGE_WEIGHTS, edge weights in mutable_graph are stored in 32 bits.
+// all weights, including the weights of contracted edges, then need to fit.
+#ifdef SMALL_EDGE_WEIGHTS
+typedef uint32_t RevEdgeWeight;
+#else
+typedef EdgeWeight RevEdgeWeight;
+#endif
 
+// flows are not stored in the edges, solvers keep them in their own arrays.
 struct RevEdge {
-    NodeID     target;
-    EdgeWeight weight;
-    EdgeID     reverse_edge;
-    FlowType   flow;
+    NodeID        target;
+    // index in the adjacency of 'target', bounded by the number of vertices
+    NodeID        reverse_edge;
+    RevEdgeWeight weight;
 
     RevEdge() { }
 
-    explicit RevEdge(NodeID p_target) : target(p_target), weight(1), flow(0) { }
+    explicit RevEdge(NodeID p_target) : target(p_target), weight(1) { }
 
     RevEdge(NodeID p_target, EdgeWeight p_wgt)
-        : target(p_target), weight(p_wgt), flow(0) { }
+        : target(p_target), weight(p_wgt) { }
 
     RevEdge(NodeID p_target, EdgeWeight p_wgt, EdgeID p_rev)
         : target(p_target),
-          weight(p_wgt),
-          reverse_edge(p_rev),
-          flow(0) { }
-
-    RevEdge(NodeID p_target, EdgeWeight p_wgt, EdgeID p_rev, FlowType p_flow)
-        : target(p_target),
-          weight(p_wgt),
           reverse_edge(p_rev),
-          flow(p_flow) { }
+          weight(p_wgt) { }
 };
 
 class mutable_graph {
  public:
     static constexpr bool debug = false;
+    // graphs with fewer vertices are rebuilt sequentially. most of them are
+    // problem graphs contracted by the pinned threads of branch_multicut,
+    // where a parallel region only adds threads on the same core
+    static constexpr NodeID default_parallel_threshold = 1 << 16;
 
-    mutable_graph() : last_node(0), num_edges(0), partition_count(0) { }
+    // used by the tests to run the parallel paths on small graphs. not
+    // synchronized, only set it while no graph is built or contracted
+    static void setParallelThreshold(NodeID threshold) {
+        parallel_threshold = threshold;
+    }
+
+    mutable_graph() : last_node(0), num_edges(0), partition_count(0),
+                      m_current_round(0) { }
     virtual ~mutable_graph() { }
 
     mutable_graph(const mutable_graph& copy)
@@ -67,7 +83,8 @@ class mutable_graph {
           last_node(copy.last_node),
           num_edges(copy.num_edges),
           partition_count(copy.partition_count),
-          original_nodes(copy.original_nodes) { }
+          original_nodes(copy.original_nodes),
+          m_current_round(0) { }
 
     void start_construction(NodeID n) {
         vertices.resize(n);
@@ -162,17 +179,38 @@ class mutable_graph {
         return vertices[e.target][e.reverse_edge].target;
     }
 
-    void setEdgeFlow(NodeID node, EdgeID edge, FlowType flow) {
-        vertices[node][edge].flow = flow;
+    void finish_construction() {
+        LOG << "Unused function end_construction()";
+        LOG << "This is just here for compatibility reasons with graph_access";
     }
 
-    FlowType getEdgeFlow(NodeID node, EdgeID edge) const {
-        return vertices[node][edge].flow;
+    // direct construction after start_construction(n): adjacency arrays are
+    // allocated with their final degrees and filled directly, including the
+    // reverse edge indices. edges can be written in parallel.
+    // finish_construction_hacky() computes degrees and edge count.
+    void allocate_edges_hacky(const std::vector<EdgeID>& degrees) {
+        vertices.allocate(degrees);
     }
 
-    void finish_construction() {
-        LOG << "Unused function end_construction()";
-        LOG << "This is just here for compatibility reasons with graph_access";
+    void new_edge_hacky(NodeID source, EdgeID e, NodeID target,
+                        EdgeWeight wgt, EdgeID rev) {
+        vertices[source][e] = RevEdge(target, wgt, rev);
+    }
+
+    void finish_construction_hacky(bool parallel = true) {
+        EdgeID edges = 0;
+#pragma omp parallel for schedule(dynamic, 1024) reduction(+ : edges) \
+        if (parallel)
+        for (NodeID n = 0; n < vertices.size(); ++n) {
+            EdgeWeight deg = 0;
+            for (const RevEdge& e : vertices[n]) {
+                deg += e.weight;
+            }
+            weighted_degree[n] = deg;
+            edges += vertices[n].size();
+        }
+        num_edges = edges;
+        last_node = vertices.size();
     }
 
     /* ============================================================= */
@@ -263,6 +301,11 @@ class mutable_graph {
         return contained_in_this[node];
     }
 
+    // some original vertex contained in node, without copying the list
+    NodeID containedVertex(NodeID node) const {
+        return contained_in_this[node].front();
+    }
+
     void setContainedVertices(NodeID node, std::vector<NodeID> v) {
         contained_in_this[node] = v;
     }
@@ -336,7 +379,7 @@ class mutable_graph {
             }
         }
 
-        vertices[node] = std::move(vertices.back());
+        vertices.move_vertex(node, vertices.size() - 1);
         weighted_degree[node] = std::move(weighted_degree.back());
         partition_index[node] = std::move(partition_index.back());
         vertices.pop_back();
@@ -389,35 +432,30 @@ class mutable_graph {
 
         RevEdge e = vertices[node][edge];
         NodeID target = e.target;
-        EdgeID del_id = 0;
-        EdgeWeight del_wgt = 0;
+        EdgeID del_id = edge;
+        EdgeWeight del_wgt = e.weight;
 
-        std::unordered_map<NodeID, std::tuple<EdgeWeight, EdgeID, EdgeID> > map;
-        // store targets (and additional info) of vertices
-        // in unordered_map to find vertices that are in shared neighbourhood
+        // mark neighbours of 'node' with the position of the edge to them,
+        // to find vertices that are in shared neighbourhood
+        newMarkerRound();
         for (EdgeID ed : edges_of(node)) {
             if (ed != edge) {
-                RevEdge del_ed = vertices[node][ed];
-                map.emplace(getEdgeTarget(node, ed),
-                            std::make_tuple(del_ed.target,
-                                            del_ed.reverse_edge,
-                                            ed));
-            } else {
-                del_wgt = vertices[node][ed].weight;
-                del_id = ed;
+                setMarker(getEdgeTarget(node, ed), ed);
             }
         }
 
         for (EdgeID ed : edges_of(target)) {
             if (ed != e.reverse_edge) {
                 RevEdge del_edge = vertices[target][ed];
-                NodeID e_target = getEdgeTarget(target, ed);
+                NodeID e_target = del_edge.target;
                 // neighbour of 'target' also in neighbourhood of 'node'
-                if (map.count(e_target) > 0) {
-                    // sum up edge weights
-                    auto [tgt, rev, ed2] = map[e_target];
+                if (isMarked(e_target)) {
+                    // sum up edge weights. reverse edge is read here, as
+                    // deleting edges can move it inside of 'e_target'
+                    EdgeID ed2 = m_marker_position[e_target];
+                    EdgeID rev = vertices[node][ed2].reverse_edge;
                     vertices[node][ed2].weight += del_edge.weight;
-                    vertices[tgt][rev].weight += del_edge.weight;
+                    vertices[e_target][rev].weight += del_edge.weight;
 
                     weighted_degree[node] += del_edge.weight;
 
@@ -448,7 +486,7 @@ class mutable_graph {
             current_position[n] = target;
         }
 
-        vertices[target] = std::move(vertices.back());
+        vertices.move_vertex(target, vertices.size() - 1);
         weighted_degree[target] = std::move(weighted_degree.back());
         partition_index[target] = std::move(partition_index.back());
         vertices.pop_back();
@@ -457,9 +495,11 @@ class mutable_graph {
         contained_in_this.pop_back();
 
         // remap all reverse edges of vertex that was now moved to 'target'
-        for (EdgeID ed : edges_of(target)) {
-            RevEdge e = vertices[target][ed];
-            vertices[e.target][e.reverse_edge].target = target;
+        if (target < vertices.size()) {
+            for (EdgeID ed : edges_of(target)) {
+                RevEdge e = vertices[target][ed];
+                vertices[e.target][e.reverse_edge].target = target;
+            }
         }
 
         // delete edge of 'node' to 'target', remap reverse
@@ -470,32 +510,42 @@ class mutable_graph {
         return target;
     }
 
+    // fallback for callers that collect the vertex set in a hash set
     void contractVertexSet(const std::unordered_set<NodeID>& vertex_set) {
-        std::vector<NodeID> vertex_set_vec;
-        NodeID first = UNDEFINED_NODE;
-        size_t idx = 0;
+        contractVertexSet(
+            std::vector<NodeID>(vertex_set.begin(), vertex_set.end()));
+    }
+
+    // contracts all vertices in 'vertex_set' into the one with lowest ID.
+    // duplicate entries are ignored.
+    void contractVertexSet(const std::vector<NodeID>& vertex_set) {
+        if (vertex_set.empty())
+            return;
+
+        NodeID first = *std::min_element(vertex_set.begin(),
+                                         vertex_set.end());
 
-        for (auto i : vertex_set) {
-            if (i < first) {
-                first = i;
-                idx = vertex_set_vec.size();
+        // members of the set are marked with UNDEFINED_EDGE, neighbours of
+        // the contracted vertex with the position of the edge to them
+        newMarkerRound();
+        std::vector<NodeID> vertex_set_vec;
+        for (NodeID v : vertex_set) {
+            if (!isMarked(v)) {
+                setMarker(v, UNDEFINED_EDGE);
+                if (v != first) {
+                    vertex_set_vec.emplace_back(v);
+                }
             }
-            vertex_set_vec.emplace_back(i);
         }
 
-        vertex_set_vec.erase(vertex_set_vec.begin() + idx);
-
         std::vector<RevEdge> edges;
-        std::unordered_map<NodeID, std::tuple<NodeID, EdgeID, EdgeID> > map;
 
         for (EdgeID e : edges_of(first)) {
             NodeID target = getEdgeTarget(first, e);
-            if (vertex_set.count(target) == 0) {
+            if (!isMarked(target)) {
                 RevEdge edge_to_set = vertices[first][e];
                 edges.push_back(vertices[first][e]);
-                map.emplace(target, std::make_tuple(edge_to_set.target,
-                                                    edge_to_set.reverse_edge,
-                                                    edges.size() - 1));
+                setMarker(target, edges.size() - 1);
                 vertices[edge_to_set.target]
                 [edge_to_set.reverse_edge].reverse_edge = edges.size() - 1;
             } else {
@@ -504,37 +554,31 @@ class mutable_graph {
             }
         }
 
-        vertices[first].swap(edges);
+        vertices.assign(first, edges);
 
         for (NodeID n : vertex_set_vec) {
-            if (n == first)
-                continue;
-
             last_node--;
 
             for (EdgeID e : edges_of(n)) {
                 NodeID target = getEdgeTarget(n, e);
-                if (vertex_set.count(target) == 0) {
+                if (!isMarked(target)
+                    || m_marker_position[target] != UNDEFINED_EDGE) {
                     RevEdge del_edge = vertices[n][e];
                     // neighbour of 'target' also in neighbourhood of 'node'
-                    if (map.count(target) > 0) {
-                        // sum up edge weights
-                        auto[tgt, rev, ed2] = map[target];
+                    if (isMarked(target)) {
+                        // sum up edge weights. reverse edge is read here, as
+                        // deleting edges can move it inside of 'target'
+                        EdgeID ed2 = m_marker_position[target];
+                        EdgeID rev = vertices[first][ed2].reverse_edge;
 
                         VIECUT_ASSERT_EQ(vertices[first][ed2].weight,
-                                         vertices[tgt][rev].weight);
+                                         vertices[target][rev].weight);
                         vertices[first][ed2].weight += del_edge.weight;
-                        vertices[tgt][rev].weight += del_edge.weight;
+                        vertices[target][rev].weight += del_edge.weight;
 
                         weighted_degree[first] += del_edge.weight;
                         num_edges -= 2;
 
-                        if (vertices[tgt].size() - 1 == rev) {
-                            // we need to move position of reverse edge in 'map'
-                            map[target] = std::make_tuple(
-                                tgt, del_edge.reverse_edge, ed2);
-                        }
-
                         internalDeleteEdge(del_edge.target,
                                            del_edge.reverse_edge);
                     } else {
@@ -550,11 +594,7 @@ class mutable_graph {
                         vertices[first].emplace_back(target, del_edge.weight,
                                                      del_edge.reverse_edge);
                         weighted_degree[first] += del_edge.weight;
-                        map.emplace(
-                            target,
-                            std::make_tuple(target,
-                                            del_edge.reverse_edge,
-                                            vertices[first].size() - 1));
+                        setMarker(target, vertices[first].size() - 1);
                     }
                 } else {
                     --num_edges;
@@ -579,7 +619,7 @@ class mutable_graph {
                     contained_in_this[vtx].emplace_back(n);
                     current_position[n] = vtx;
                 }
-                vertices[vtx] = std::move(vertices.back());
+                vertices.move_vertex(vtx, vertices.size() - 1);
                 weighted_degree[vtx] = std::move(weighted_degree.back());
                 partition_index[vtx] = std::move(partition_index.back());
 
@@ -599,66 +639,254 @@ class mutable_graph {
         }
     }
 
-    // Graph class translation
-    static std::shared_ptr<mutable_graph> from_graph_access(
-        std::shared_ptr<graph_access> G) {
-        std::shared_ptr<mutable_graph> m_G = std::make_shared<mutable_graph>();
-        std::vector<NodeID> last_incident(G->number_of_nodes(), UNDEFINED_NODE);
-        m_G->start_construction(G->number_of_nodes());
-        for (NodeID n : G->nodes()) {
-            m_G->new_node();
-            for (EdgeID e : G->edges_of(n)) {
-                NodeID t = G->getEdgeTarget(e);
-                if (last_incident[t] == n) {
-                    // double edge
-                    // LOG1 << "double edge";
-
-                    for (EdgeID e2 : m_G->edges_of(n)) {
-                        if (m_G->getEdgeTarget(n, e2) == t) {
-                            m_G->setEdgeWeight(n, e2,
-                                               m_G->getEdgeWeight(n, e2)
-                                               + G->getEdgeWeight(e));
-                            break;
-                        }
-                    }
-                } else {
-                    last_incident[t] = n;
-                    m_G->new_edge(n, G->getEdgeTarget(e), G->getEdgeWeight(e));
+    // contracts every block of a vertex partition into a single vertex.
+    // mapping[n] in [0, num_blocks) is the new ID of vertex n. instead of
+    // contracting the blocks one by one, the graph is rebuilt in a single
+    // parallel pass, merging parallel edges and removing edges inside blocks.
+    // a contracted vertex takes the partition index of its lowest member.
+    void contractPartition(const std::vector<NodeID>& mapping,
+                           NodeID num_blocks) {
+        NodeID n = number_of_nodes();
+        bool parallel = n > parallel_threshold;
+
+        // members of each block in ascending order
+        std::vector<NodeID> member_start(num_blocks + 1, 0);
+        std::vector<EdgeID> edge_start(num_blocks + 1, 0);
+#pragma omp parallel for schedule(static) if (parallel)
+        for (NodeID v = 0; v < n; ++v) {
+            __sync_fetch_and_add(&member_start[mapping[v]], 1);
+            __sync_fetch_and_add(&edge_start[mapping[v]],
+                                 get_first_invalid_edge(v));
+        }
+        vector::prefix_sum(&member_start, parallel);
+        vector::prefix_sum(&edge_start, parallel);
+
+        std::vector<NodeID> members(n);
+        std::vector<NodeID> next_member(member_start.begin(),
+                                        member_start.end() - 1);
+#pragma omp parallel for schedule(static) if (parallel)
+        for (NodeID v = 0; v < n; ++v) {
+            members[__sync_fetch_and_add(&next_member[mapping[v]], 1)] = v;
+        }
+
+        // adjacency of every block is the concatenation of its members
+        std::vector<std::pair<NodeID, EdgeWeight> > block_edges(
+            edge_start[num_blocks]);
+        std::vector<std::vector<NodeID> > contained(num_blocks);
+        std::vector<PartitionID> block_partition(num_blocks);
+#pragma omp parallel for schedule(dynamic, 1024) if (parallel)
+        for (NodeID b = 0; b < num_blocks; ++b) {
+            std::sort(members.begin() + member_start[b],
+                      members.begin() + member_start[b + 1]);
+            EdgeID pos = edge_start[b];
+            for (NodeID m = member_start[b]; m < member_start[b + 1]; ++m) {
+                NodeID v = members[m];
+                for (const RevEdge& e : vertices[v]) {
+                    block_edges[pos++] =
+                        std::make_pair(mapping[e.target], e.weight);
+                }
+                for (NodeID c : contained_in_this[v]) {
+                    contained[b].emplace_back(c);
+                    current_position[c] = b;
                 }
             }
+            block_partition[b] = partition_index[members[member_start[b]]];
         }
-        return m_G;
+
+        auto G = buildUndirected(
+            num_blocks,
+            [&edge_start](NodeID b) {
+                return edge_start[b + 1] - edge_start[b];
+            },
+            [&edge_start, &block_edges](NodeID b, EdgeID e) {
+                return block_edges[edge_start[b] + e];
+            });
+
+        vertices = std::move(G->vertices);
+        weighted_degree = std::move(G->weighted_degree);
+        partition_index = std::move(block_partition);
+        contained_in_this = std::move(contained);
+        num_edges = G->num_edges;
+        last_node = G->last_node;
+    }
+
+    // Graph class translation
+    static std::shared_ptr<mutable_graph> from_graph_access(
+        std::shared_ptr<graph_access> G) {
+        return buildUndirected(
+            G->number_of_nodes(),
+            [&G](NodeID n) { return G->getNodeDegree(n); },
+            [&G](NodeID n, EdgeID e) {
+                EdgeID edge = G->get_first_edge(n) + e;
+                return std::make_pair(G->getEdgeTarget(edge),
+                                      G->getEdgeWeight(edge));
+            });
     }
 
     std::shared_ptr<graph_access> to_graph_access() {
         std::shared_ptr<graph_access> G = std::make_shared<graph_access>();
-        G->start_construction(number_of_nodes(), number_of_edges());
-        for (NodeID n : G->nodes()) {
-            G->new_node();
-            for (EdgeID e : edges_of(n)) {
-                EdgeID edge = G->new_edge(n, getEdgeTarget(n, e));
-                G->setEdgeWeight(edge, getEdgeWeight(n, e));
+        std::vector<EdgeID> first_edge(number_of_nodes() + 1, 0);
+#pragma omp parallel for schedule(static)
+        for (NodeID n = 0; n < number_of_nodes(); ++n) {
+            first_edge[n] = vertices[n].size();
+        }
+        vector::prefix_sum(&first_edge);
+
+        G->start_construction(number_of_nodes(), 0);
+        for (NodeID n = 0; n < number_of_nodes(); ++n) {
+            G->new_node_hacky(first_edge[n + 1]);
+        }
+        G->resize_m(first_edge[number_of_nodes()]);
+
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (NodeID n = 0; n < number_of_nodes(); ++n) {
+            EdgeID edge = first_edge[n];
+            for (const RevEdge& e : vertices[n]) {
+                G->setEdgeTarget(edge, e.target);
+                G->setEdgeWeight(edge, e.weight);
+                ++edge;
             }
         }
         G->finish_construction();
         return G;
     }
 
+    // new graph with the same vertices and edges but without any
+    // contraction information, parallel edges are merged
     std::shared_ptr<mutable_graph> simplify() {
-        std::shared_ptr<mutable_graph> G = std::make_shared<mutable_graph>();
-        G->start_construction(number_of_nodes());
-        for (NodeID n : G->nodes()) {
-            G->new_node();
+        return buildUndirected(
+            number_of_nodes(),
+            [this](NodeID n) { return get_first_invalid_edge(n); },
+            [this](NodeID n, EdgeID e) {
+                return std::make_pair(vertices[n][e].target,
+                                      vertices[n][e].weight);
+            });
+    }
 
-            for (EdgeID e : edges_of(n)) {
-                G->new_edge(n, getEdgeTarget(n, e), getEdgeWeight(n, e));
+ private:
+    // builds a graph from an undirected adjacency structure. every edge is
+    // taken from the adjacency of its endpoint with lower ID, parallel edges
+    // are merged with per-thread marker arrays in O(m) and self-loops are
+    // removed.
+    //
+    // the adjacency of every vertex lists its lower neighbors in ascending
+    // order followed by its higher neighbors in input order. this is the
+    // same order that sequential insertion with new_edge creates.
+    template <typename DegreeFunction, typename EdgeFunction>
+    static std::shared_ptr<mutable_graph> buildUndirected(
+        NodeID num_nodes, DegreeFunction degree, EdgeFunction edge) {
+        auto G = std::make_shared<mutable_graph>();
+        G->start_construction(num_nodes);
+        auto& adjacency = G->vertices;
+        bool parallel = num_nodes > parallel_threshold;
+
+        std::vector<EdgeID> offset(num_nodes + 1, 0);
+#pragma omp parallel for schedule(static) if (parallel)
+        for (NodeID n = 0; n < num_nodes; ++n) {
+            offset[n] = degree(n);
+        }
+        vector::prefix_sum(&offset, parallel);
+
+        // higher neighbors, parallel edges are merged into the first one in
+        // input order. position[t] is the index of neighbor t in the
+        // higher neighbors of the current vertex, if it was already seen
+        std::vector<std::pair<NodeID, EdgeWeight> > higher(offset[num_nodes]);
+        std::vector<EdgeID> higher_degree(num_nodes, 0);
+        std::vector<EdgeID> lower_degree(num_nodes, 0);
+#pragma omp parallel if (parallel)
+        {
+            std::vector<EdgeID> position(num_nodes, UNDEFINED_EDGE);
+#pragma omp for schedule(dynamic, 1024)
+            for (NodeID n = 0; n < num_nodes; ++n) {
+                EdgeID deg = offset[n + 1] - offset[n];
+                auto neighbors = higher.begin() + offset[n];
+                EdgeID num_higher = 0;
+                for (EdgeID e = 0; e < deg; ++e) {
+                    auto [tgt, wgt] = edge(n, e);
+                    if (tgt <= n)
+                        continue;
+
+                    if (position[tgt] == UNDEFINED_EDGE) {
+                        position[tgt] = num_higher;
+                        neighbors[num_higher++] = std::make_pair(tgt, wgt);
+                    } else {
+                        neighbors[position[tgt]].second += wgt;
+                    }
+                }
+
+                for (EdgeID e = 0; e < num_higher; ++e) {
+                    NodeID tgt = neighbors[e].first;
+                    position[tgt] = UNDEFINED_EDGE;
+                    __sync_fetch_and_add(&lower_degree[tgt], 1);
+                }
+                higher_degree[n] = num_higher;
             }
         }
-        G->finish_construction();
+
+        std::vector<EdgeID> degrees(num_nodes);
+#pragma omp parallel for schedule(static) if (parallel)
+        for (NodeID n = 0; n < num_nodes; ++n) {
+            degrees[n] = lower_degree[n] + higher_degree[n];
+        }
+        adjacency.allocate(degrees, parallel);
+
+        // higher neighbors go behind the lower neighbors, the reverse edges
+        // are placed in the lower part of the target. without a parallel
+        // region, the vertices are handled in ascending order and the lower
+        // neighbors are already sorted
+        std::vector<EdgeID> next_lower(num_nodes, 0);
+#pragma omp parallel for schedule(dynamic, 1024) if (parallel)
+        for (NodeID n = 0; n < num_nodes; ++n) {
+            for (EdgeID e = 0; e < higher_degree[n]; ++e) {
+                auto [tgt, wgt] = higher[offset[n] + e];
+                EdgeID pos = __sync_fetch_and_add(&next_lower[tgt], 1);
+                adjacency[n][lower_degree[n] + e] = RevEdge(tgt, wgt, pos);
+                adjacency[tgt][pos] = RevEdge(n, wgt, lower_degree[n] + e);
+            }
+        }
+
+        // sort lower neighbors and point the reverse edges at them
+        if (parallel) {
+#pragma omp parallel for schedule(dynamic, 1024)
+            for (NodeID n = 0; n < num_nodes; ++n) {
+                auto adj = adjacency[n];
+                std::sort(adj.begin(), adj.begin() + lower_degree[n],
+                          [](const RevEdge& a, const RevEdge& b) {
+                              return a.target < b.target;
+                          });
+                for (EdgeID e = 0; e < lower_degree[n]; ++e) {
+                    adjacency[adj[e].target][adj[e].reverse_edge]
+                    .reverse_edge = e;
+                }
+            }
+        }
+
+        G->finish_construction_hacky(parallel);
         return G;
     }
 
- private:
+    // starts a new round of marking vertices. markers are timestamped with
+    // the round, so they never have to be cleared.
+    void newMarkerRound() {
+        if (m_marker_round.size() < vertices.size()) {
+            m_marker_round.resize(vertices.size(), 0);
+            m_marker_position.resize(vertices.size());
+        }
+        if (++m_current_round == 0) {
+            std::fill(m_marker_round.begin(), m_marker_round.end(), 0);
+            m_current_round = 1;
+        }
+    }
+
+    void setMarker(NodeID n, EdgeID position) {
+        m_marker_round[n] = m_current_round;
+        m_marker_position[n] = position;
+    }
+
+    bool isMarked(NodeID n) const {
+        return m_marker_round[n] == m_current_round;
+    }
+
     void internalDeleteEdge(NodeID n, EdgeID e) {
         if (vertices[n].size() > e + 1) {
             vertices[n][e] = std::move(vertices[n][vertices[n].size() - 1]);
@@ -680,7 +908,7 @@ class mutable_graph {
     }
 
     std::vector<PartitionID> partition_index;
-    std::vector<std::vector<RevEdge> > vertices;
+    adjacency_arena<RevEdge> vertices;
     std::vector<EdgeWeight> weighted_degree;
     std::vector<NodeID> current_position;
     std::vector<std::vector<NodeID> > contained_in_this;
@@ -689,6 +917,13 @@ class mutable_graph {
     EdgeID num_edges;
     PartitionID partition_count;
     NodeID original_nodes;
+
+    // workspace of contractEdge and contractVertexSet, not copied
+    std::vector<uint32_t> m_marker_round;
+    std::vector<EdgeID> m_marker_position;
+    uint32_t m_current_round;
+
+    static inline NodeID parallel_threshold = default_parallel_threshold;
 };
 
 [[maybe_unused]] static std::string toStringUnweighted(
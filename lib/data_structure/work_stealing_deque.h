@@ -0,0 +1,148 @@
+/******************************************************************************
+ * work_stealing_deque.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Lock-free work stealing deque of pointers (Chase and Lev, SPAA'05, with
+// the memory orderings of Le et al., PPoPP'13). The owner thread pushes and
+// takes elements at the bottom, other threads steal from the top. Arrays
+// that are replaced when the deque grows are kept until destruction, as
+// thieves might still read from them.
+template <typename T>
+class work_stealing_deque {
+ public:
+    explicit work_stealing_deque(size_t log_capacity = 3)
+        : m_top(0),
+          m_bottom(0) {
+        m_arrays.emplace_back(new circular_array(log_capacity));
+        m_array = m_arrays.back().get();
+    }
+
+    work_stealing_deque(const work_stealing_deque&) = delete;
+    work_stealing_deque& operator = (const work_stealing_deque&) = delete;
+
+    ~work_stealing_deque() { }
+
+    // only called by the owner
+    void push(T* item) {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_acquire);
+        circular_array* a = m_array.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(a->size()) - 1) {
+            m_arrays.emplace_back(a->grow(b, t));
+            a = m_arrays.back().get();
+            m_array.store(a, std::memory_order_release);
+        }
+        a->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // only called by the owner, returns nullptr if the deque is empty
+    T* take() {
+        int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        circular_array* a = m_array.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+
+        T* item = nullptr;
+        if (t <= b) {
+            item = a->get(b);
+            if (t == b) {
+                // last element, race against thieves
+                if (!m_top.compare_exchange_strong(
+                        t, t + 1, std::memory_order_seq_cst,
+                        std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // called by any thread, returns nullptr if the deque is empty or
+    // another thread took the element first
+    T* steal() {
+        int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = m_bottom.load(std::memory_order_acquire);
+
+        if (t < b) {
+            circular_array* a = m_array.load(std::memory_order_acquire);
+            T* item = a->get(t);
+            if (m_top.compare_exchange_strong(
+                    t, t + 1, std::memory_order_seq_cst,
+                    std::memory_order_relaxed)) {
+                return item;
+            }
+        }
+        return nullptr;
+    }
+
+    // number of elements, only exact if no other thread modifies the deque
+    size_t size() const {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+ private:
+    class circular_array {
+     public:
+        explicit circular_array(size_t log_size)
+            : m_log_size(log_size),
+              m_items(new std::atomic<T*>[1UL << log_size]) { }
+
+        size_t size() const {
+            return 1UL << m_log_size;
+        }
+
+        T* get(int64_t i) const {
+            return m_items[i & (size() - 1)].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t i, T* item) {
+            m_items[i & (size() - 1)].store(item, std::memory_order_relaxed);
+        }
+
+        circular_array* grow(int64_t bottom, int64_t top) const {
+            circular_array* a = new circular_array(m_log_size + 1);
+            for (int64_t i = top; i < bottom; ++i) {
+                a->put(i, get(i));
+            }
+            return a;
+        }
+
+     private:
+        size_t m_log_size;
+        std::unique_ptr<std::atomic<T*>[]> m_items;
+    };
+
+    // top and bottom on different cache lines, as thieves only modify top
+    alignas(64) std::atomic<int64_t> m_top;
+    alignas(64) std::atomic<int64_t> m_bottom;
+    std::atomic<circular_array*> m_array;
+    // all arrays ever used by the deque, only modified by the owner
+    std::vector<std::unique_ptr<circular_array> > m_arrays;
+};
@@ -69,17 +69,7 @@ class graph_io {
 
     static std::shared_ptr<flow_graph> createFlowGraph(
         std::shared_ptr<graph_access> G) {
-        std::shared_ptr<flow_graph> fg = std::make_shared<flow_graph>();
-        fg->start_construction(G->number_of_nodes());
-
-        for (NodeID n : G->nodes()) {
-            for (EdgeID e : G->edges_of(n)) {
-                NodeID tgt = G->getEdgeTarget(e);
-                fg->new_edge(n, tgt, G->getEdgeWeight(e));
-            }
-        }
-
-        fg->finish_construction();
+        std::shared_ptr<flow_graph> fg = std::make_shared<flow_graph>(G);
 
         VIECUT_ASSERT_EQ(fg->number_of_nodes(), G->number_of_nodes());
         VIECUT_ASSERT_EQ(fg->number_of_edges(), 2 * G->number_of_edges());
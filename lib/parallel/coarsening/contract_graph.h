@@ -14,7 +14,6 @@
 #include <algorithm>
 #include <functional>
 #include <memory>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -181,9 +180,8 @@ class contraction {
     static std::shared_ptr<mutable_graph> fromUnionFind(
         std::shared_ptr<mutable_graph> G,
         union_find* uf) {
-        std::vector<std::vector<NodeID> > rev_mapping(uf->n());
-
         std::vector<NodeID> part(G->number_of_nodes(), UNDEFINED_NODE);
+        std::vector<NodeID> mapping(G->number_of_nodes());
         NodeID current_pid = 0;
 
         for (NodeID n : G->nodes()) {
@@ -191,17 +189,11 @@ class contraction {
             if (part[part_id] == UNDEFINED_NODE) {
                 part[part_id] = current_pid++;
             }
-            rev_mapping[part[part_id]].push_back(G->containedVertices(n)[0]);
+            mapping[n] = part[part_id];
         }
 
-        for (size_t i = 0; i < rev_mapping.size(); ++i) {
-            if (rev_mapping[i].size() > 1) {
-                std::unordered_set<NodeID> vtx_to_ctr;
-                for (auto v : rev_mapping[i]) {
-                    vtx_to_ctr.emplace(G->getCurrentPosition(v));
-                }
-                G->contractVertexSet(vtx_to_ctr);
-            }
+        if (current_pid < G->number_of_nodes()) {
+            G->contractPartition(mapping, current_pid);
         }
 
         return G;
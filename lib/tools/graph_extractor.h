@@ -14,6 +14,9 @@
 
 #pragma once
 
+#include <omp.h>
+
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -21,7 +24,12 @@
 #include "common/definitions.h"
 #include "data_structure/graph_access.h"
 #include "data_structure/mutable_graph.h"
+#include "tools/vector.h"
 
+// Extracts the subgraphs induced by blocks of a vertex partition.
+// New vertex IDs and the edge offsets of all extracted blocks are computed
+// with parallel prefix sums, edges are written directly to their
+// final position in the extracted graphs.
 class graph_extractor {
  public:
     graph_extractor() { }
@@ -30,76 +38,272 @@ class graph_extractor {
     std::pair<std::shared_ptr<graph_access>, std::vector<NodeID> >
     extract_block(std::shared_ptr<graph_access> G,
                   PartitionID block) {
-        auto extracted_block = std::make_shared<graph_access>();
-        // build reverse mapping
-        std::vector<NodeID> reverse_mapping;
-        NodeID nodes = 0;
-        NodeID dummy_node = G->number_of_nodes() + 1;
-        for (NodeID node : G->nodes()) {
-            if (G->getPartitionIndex(node) == block) {
-                reverse_mapping.push_back(nodes++);
-            } else {
-                reverse_mapping.push_back(dummy_node);
+        std::vector<NodeID> block_of(G->number_of_nodes());
+#pragma omp parallel for schedule(static)
+        for (NodeID n = 0; n < G->number_of_nodes(); ++n) {
+            block_of[n] = (G->getPartitionIndex(n) == block) ? 0 : 1;
+        }
+
+        auto [blocks, reverse_mapping] =
+            extract_blocks(G, block_of, 2, { true, false });
+        setDummyMapping(block_of, &reverse_mapping);
+        return std::make_pair(blocks[0], reverse_mapping);
+    }
+
+    std::pair<std::shared_ptr<mutable_graph>, std::vector<NodeID> >
+    extract_block(std::shared_ptr<mutable_graph> G,
+                  PartitionID block,
+                  const std::vector<int>& components) {
+        std::vector<NodeID> block_of(G->number_of_nodes());
+#pragma omp parallel for schedule(static)
+        for (NodeID n = 0; n < G->number_of_nodes(); ++n) {
+            block_of[n] = (components[n] == static_cast<int>(block)) ? 0 : 1;
+        }
+
+        auto [blocks, reverse_mapping] =
+            extract_blocks(G, block_of, 2, { true, false });
+        setDummyMapping(block_of, &reverse_mapping);
+        return std::make_pair(blocks[0], reverse_mapping);
+    }
+
+    // extracts all blocks b with extract[b] == true in a single pass over G.
+    // returns the extracted graphs (nullptr for blocks that are not extracted)
+    // and for each vertex its ID in the graph of its block.
+    template <typename BlockID>
+    std::pair<std::vector<std::shared_ptr<graph_access> >,
+              std::vector<NodeID> >
+    extract_blocks(std::shared_ptr<graph_access> G,
+                   const std::vector<BlockID>& block_of,
+                   size_t num_blocks,
+                   const std::vector<bool>& extract) {
+        NodeID n = G->number_of_nodes();
+        std::vector<NodeID> order, block_start, new_id;
+        blockOrder(block_of, num_blocks, &order, &block_start, &new_id);
+
+        // retained degrees in block order, prefix sum gives edge offsets
+        std::vector<EdgeID> first_edge(n + 1, 0);
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (NodeID p = 0; p < n; ++p) {
+            NodeID v = order[p];
+            BlockID b = block_of[v];
+            if (!extract[b])
+                continue;
+
+            EdgeID deg = 0;
+            for (EdgeID e : G->edges_of(v)) {
+                deg += (block_of[G->getEdgeTarget(e)] == b);
             }
+            first_edge[p] = deg;
         }
+        vector::prefix_sum(&first_edge);
 
-        extracted_block->start_construction(nodes, G->number_of_edges());
+        std::vector<std::shared_ptr<graph_access> > blocks(num_blocks);
+#pragma omp parallel for schedule(dynamic)
+        for (size_t b = 0; b < num_blocks; ++b) {
+            if (!extract[b])
+                continue;
 
-        for (NodeID node : G->nodes()) {
-            if (G->getPartitionIndex(node) == block) {
-                NodeID new_node = extracted_block->new_node();
-                for (EdgeID e : G->edges_of(node)) {
-                    NodeID target = G->getEdgeTarget(e);
-                    if (G->getPartitionIndex(target) == block) {
-                        EdgeID new_edge = extracted_block->new_edge(
-                            new_node, reverse_mapping[target]);
-                        extracted_block->setEdgeWeight(new_edge,
-                                                       G->getEdgeWeight(e));
-                    }
+            NodeID start = block_start[b];
+            NodeID end = block_start[b + 1];
+            EdgeID edge_base = first_edge[start];
+            blocks[b] = std::make_shared<graph_access>();
+            blocks[b]->start_construction(end - start, 0);
+            for (NodeID p = start; p < end; ++p) {
+                blocks[b]->new_node_hacky(first_edge[p + 1] - edge_base);
+            }
+            blocks[b]->resize_m(first_edge[end] - edge_base);
+        }
+
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (NodeID p = 0; p < n; ++p) {
+            NodeID v = order[p];
+            BlockID b = block_of[v];
+            if (!extract[b])
+                continue;
+
+            auto& block = blocks[b];
+            EdgeID e_new = first_edge[p] - first_edge[block_start[b]];
+            for (EdgeID e : G->edges_of(v)) {
+                NodeID tgt = G->getEdgeTarget(e);
+                if (block_of[tgt] == b) {
+                    block->setEdgeTarget(e_new, new_id[tgt]);
+                    block->setEdgeWeight(e_new, G->getEdgeWeight(e));
+                    ++e_new;
                 }
             }
         }
 
-        extracted_block->finish_construction();
-        return std::make_pair(extracted_block, reverse_mapping);
+#pragma omp parallel for schedule(dynamic)
+        for (size_t b = 0; b < num_blocks; ++b) {
+            if (extract[b]) {
+                blocks[b]->finish_construction();
+            }
+        }
+
+        return std::make_pair(blocks, new_id);
     }
 
-    std::pair<std::shared_ptr<mutable_graph>, std::vector<NodeID> >
-    extract_block(std::shared_ptr<mutable_graph> G,
-                  PartitionID block,
-                  const std::vector<int>& components) {
-        auto extracted_block = std::make_shared<mutable_graph>();
-
-        // build reverse mapping
-        std::vector<NodeID> reverse_mapping;
-        NodeID nodes = 0;
-        NodeID dummy_node = G->number_of_nodes() + 1;
-        for (NodeID node : G->nodes()) {
-            if (components[node] == static_cast<int>(block)) {
-                reverse_mapping.push_back(nodes++);
-            } else {
-                reverse_mapping.push_back(dummy_node);
+    // every extracted mutable_graph gets extra_vertices isolated vertices
+    // behind the vertices of its block
+    template <typename BlockID>
+    std::pair<std::vector<std::shared_ptr<mutable_graph> >,
+              std::vector<NodeID> >
+    extract_blocks(std::shared_ptr<mutable_graph> G,
+                   const std::vector<BlockID>& block_of,
+                   size_t num_blocks,
+                   const std::vector<bool>& extract,
+                   NodeID extra_vertices = 0) {
+        NodeID n = G->number_of_nodes();
+        std::vector<NodeID> order, block_start, new_id;
+        blockOrder(block_of, num_blocks, &order, &block_start, &new_id);
+
+        // position of every retained edge in the adjacency of the extracted
+        // vertex, needed to set reverse edge indices. only the edges of
+        // vertices in extracted blocks get an entry
+        std::vector<EdgeID> edge_offset(n + 1, 0);
+#pragma omp parallel for schedule(static)
+        for (NodeID v = 0; v < n; ++v) {
+            if (extract[block_of[v]]) {
+                edge_offset[v] = G->get_first_invalid_edge(v);
+            }
+        }
+        vector::prefix_sum(&edge_offset);
+
+        std::vector<EdgeID> new_position(edge_offset[n], UNDEFINED_EDGE);
+        std::vector<EdgeID> degree(n, 0);
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (NodeID v = 0; v < n; ++v) {
+            BlockID b = block_of[v];
+            if (!extract[b])
+                continue;
+
+            EdgeID deg = 0;
+            for (EdgeID e : G->edges_of(v)) {
+                if (block_of[G->getEdgeTarget(v, e)] == b) {
+                    new_position[edge_offset[v] + e] = deg++;
+                }
+            }
+            degree[v] = deg;
+        }
+
+        std::vector<std::shared_ptr<mutable_graph> > blocks(num_blocks);
+        std::vector<std::vector<EdgeID> > block_degrees(num_blocks);
+#pragma omp parallel for schedule(dynamic)
+        for (size_t b = 0; b < num_blocks; ++b) {
+            if (extract[b]) {
+                block_degrees[b].resize(
+                    block_start[b + 1] - block_start[b] + extra_vertices, 0);
             }
         }
 
-        extracted_block->start_construction(nodes);
+#pragma omp parallel for schedule(static)
+        for (NodeID v = 0; v < n; ++v) {
+            if (extract[block_of[v]]) {
+                block_degrees[block_of[v]][new_id[v]] = degree[v];
+            }
+        }
 
-        for (NodeID node : G->nodes()) {
-            if (components[node] == static_cast<int>(block)) {
-                NodeID new_node = extracted_block->new_node();
-                for (EdgeID e : G->edges_of(node)) {
-                    NodeID target = G->getEdgeTarget(node, e);
-                    EdgeWeight wgt = G->getEdgeWeight(node, e);
-                    if (components[target] == static_cast<int>(block)) {
-                        extracted_block->new_edge(new_node,
-                                                  reverse_mapping[target],
-                                                  wgt);
-                    }
+#pragma omp parallel for schedule(dynamic)
+        for (size_t b = 0; b < num_blocks; ++b) {
+            if (extract[b]) {
+                blocks[b] = std::make_shared<mutable_graph>();
+                blocks[b]->start_construction(block_degrees[b].size());
+                blocks[b]->allocate_edges_hacky(block_degrees[b]);
+            }
+        }
+
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (NodeID v = 0; v < n; ++v) {
+            BlockID b = block_of[v];
+            if (!extract[b])
+                continue;
+
+            auto& block = blocks[b];
+            NodeID v_new = new_id[v];
+            for (EdgeID e : G->edges_of(v)) {
+                EdgeID pos = new_position[edge_offset[v] + e];
+                if (pos != UNDEFINED_EDGE) {
+                    NodeID tgt = G->getEdgeTarget(v, e);
+                    EdgeID rev = G->getReverseEdge(v, e);
+                    block->new_edge_hacky(v_new, pos, new_id[tgt],
+                                          G->getEdgeWeight(v, e),
+                                          new_position[edge_offset[tgt] + rev]);
                 }
             }
         }
 
-        extracted_block->finish_construction();
-        return std::make_pair(extracted_block, reverse_mapping);
+#pragma omp parallel for schedule(dynamic)
+        for (size_t b = 0; b < num_blocks; ++b) {
+            if (extract[b]) {
+                blocks[b]->finish_construction_hacky();
+            }
+        }
+
+        return std::make_pair(blocks, new_id);
+    }
+
+ private:
+    // stable parallel counting sort of the vertices by block.
+    // order lists the vertices of block b in [block_start[b], block_start[b+1])
+    // and new_id is the position of each vertex inside its block.
+    template <typename BlockID>
+    void blockOrder(const std::vector<BlockID>& block_of,
+                    size_t num_blocks,
+                    std::vector<NodeID>* o,
+                    std::vector<NodeID>* bs,
+                    std::vector<NodeID>* ni) {
+        std::vector<NodeID>& order = *o;
+        std::vector<NodeID>& block_start = *bs;
+        std::vector<NodeID>& new_id = *ni;
+        NodeID n = block_of.size();
+
+        size_t chunks = omp_get_max_threads();
+        if (chunks * num_blocks > 4 * static_cast<size_t>(n) + 1024) {
+            // per-chunk counters would be larger than the graph
+            chunks = 1;
+        }
+        size_t chunk_size = (n + chunks - 1) / chunks;
+
+        // counters are block-major, so the prefix sum keeps the sort stable
+        std::vector<NodeID> count(chunks * num_blocks + 1, 0);
+#pragma omp parallel for schedule(static, 1)
+        for (size_t c = 0; c < chunks; ++c) {
+            NodeID end = std::min<size_t>(n, (c + 1) * chunk_size);
+            for (NodeID v = c * chunk_size; v < end; ++v) {
+                ++count[block_of[v] * chunks + c];
+            }
+        }
+        vector::prefix_sum(&count);
+
+        block_start.resize(num_blocks + 1);
+        for (size_t b = 0; b < num_blocks; ++b) {
+            block_start[b] = count[b * chunks];
+        }
+        block_start[num_blocks] = n;
+
+        order.resize(n);
+        new_id.resize(n);
+#pragma omp parallel for schedule(static, 1)
+        for (size_t c = 0; c < chunks; ++c) {
+            NodeID end = std::min<size_t>(n, (c + 1) * chunk_size);
+            for (NodeID v = c * chunk_size; v < end; ++v) {
+                BlockID b = block_of[v];
+                NodeID pos = count[b * chunks + c]++;
+                order[pos] = v;
+                new_id[v] = pos - block_start[b];
+            }
+        }
+    }
+
+    void setDummyMapping(const std::vector<NodeID>& block_of,
+                         std::vector<NodeID>* rm) {
+        std::vector<NodeID>& reverse_mapping = *rm;
+        NodeID dummy_node = block_of.size() + 1;
+#pragma omp parallel for schedule(static)
+        for (NodeID n = 0; n < block_of.size(); ++n) {
+            if (block_of[n] != 0) {
+                reverse_mapping[n] = dummy_node;
+            }
+        }
     }
 };
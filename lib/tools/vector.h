@@ -10,6 +10,8 @@
 
 #pragma once
 
+#include <omp.h>
+
 #include <algorithm>
 #include <vector>
 
@@ -19,4 +21,52 @@ class vector {
     static bool contains(const std::vector<T>& vec, const T& elem) {
         return (std::find(vec.begin(), vec.end(), elem) != vec.end());
     }
+
+    // exclusive prefix sum over vec, computed in one block per thread.
+    // afterwards vec[i] holds the sum of all elements before i,
+    // the return value is the sum of all elements. if parallel is not set,
+    // no parallel region is started
+    template <typename T>
+    static T prefix_sum(std::vector<T>* v, bool parallel = true) {
+        std::vector<T>& vec = *v;
+        std::vector<T> block_sum;
+        size_t block_size = 0;
+
+#pragma omp parallel if (parallel)
+        {
+#pragma omp single
+            {
+                size_t threads = omp_get_num_threads();
+                block_sum.resize(threads + 1, 0);
+                block_size = (vec.size() + threads - 1) / threads;
+            }
+
+            size_t id = omp_get_thread_num();
+            size_t begin = std::min(vec.size(), id * block_size);
+            size_t end = std::min(vec.size(), begin + block_size);
+
+            T sum = 0;
+            for (size_t i = begin; i < end; ++i) {
+                T val = vec[i];
+                vec[i] = sum;
+                sum += val;
+            }
+            block_sum[id + 1] = sum;
+
+#pragma omp barrier
+#pragma omp single
+            {
+                for (size_t i = 1; i < block_sum.size(); ++i) {
+                    block_sum[i] += block_sum[i - 1];
+                }
+            }
+
+            T offset = block_sum[id];
+            for (size_t i = begin; i < end; ++i) {
+                vec[i] += offset;
+            }
+        }
+
+        return block_sum.back();
+    }
 };
@@ -0,0 +1,208 @@
+/******************************************************************************
+ * connected_components_test.cpp
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#include <omp.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "algorithms/misc/connected_components.h"
+#include "algorithms/misc/strongly_connected_components.h"
+#include "data_structure/graph_access.h"
+#include "data_structure/mutable_graph.h"
+#include "gtest/gtest.h"
+#include "io/graph_io.h"
+#include "tools/graph_extractor.h"
+
+// creates 'num_paths' paths of length 'length' and connects some random
+// pairs of vertices inside each path
+std::shared_ptr<graph_access> make_paths(size_t num_paths, size_t length) {
+    std::mt19937 mt(42);
+    std::uniform_int_distribution<NodeID> dist(0, length - 1);
+    NodeID n = num_paths * length;
+    std::vector<std::vector<NodeID> > adj(n);
+
+    for (size_t p = 0; p < num_paths; ++p) {
+        NodeID base = p * length;
+        for (size_t i = 0; i + 1 < length; ++i) {
+            adj[base + i].emplace_back(base + i + 1);
+            adj[base + i + 1].emplace_back(base + i);
+        }
+
+        for (size_t i = 0; i < length / 4; ++i) {
+            NodeID u = base + dist(mt);
+            NodeID v = base + dist(mt);
+            if (u != v) {
+                adj[u].emplace_back(v);
+                adj[v].emplace_back(u);
+            }
+        }
+    }
+
+    EdgeID m = 0;
+    for (const auto& a : adj) {
+        m += a.size();
+    }
+
+    auto G = std::make_shared<graph_access>();
+    G->start_construction(n, m);
+    for (NodeID v = 0; v < n; ++v) {
+        G->new_node();
+        for (NodeID t : adj[v]) {
+            G->new_edge(v, t);
+        }
+    }
+    G->finish_construction();
+    return G;
+}
+
+TEST(ConnectedComponentsTest, SingleComponent) {
+    auto G = graph_io::readGraphWeighted(std::string(VIECUT_PATH)
+                                         + "/graphs/small.metis");
+    connected_components cc;
+    std::vector<int> comp;
+    ASSERT_EQ(cc.find_components(G, &comp), 1);
+    for (int c : comp) {
+        ASSERT_EQ(c, 0);
+    }
+}
+
+TEST(ConnectedComponentsTest, IsolatedVertices) {
+    auto G = std::make_shared<graph_access>();
+    G->start_construction(5, 0);
+    for (size_t i = 0; i < 5; ++i) {
+        G->new_node();
+    }
+    G->finish_construction();
+
+    connected_components cc;
+    std::vector<int> comp;
+    ASSERT_EQ(cc.find_components(G, &comp), 5);
+    for (NodeID n : G->nodes()) {
+        ASSERT_EQ(comp[n], static_cast<int>(n));
+    }
+}
+
+TEST(ConnectedComponentsTest, SameAsSCC) {
+    for (int threads : { 1, 4 }) {
+        omp_set_num_threads(threads);
+        for (size_t paths : { 1, 7, 50 }) {
+            auto G = make_paths(paths, 1000);
+            connected_components cc;
+            strongly_connected_components scc;
+            std::vector<int> comp;
+            std::vector<int> scc_comp(G->number_of_nodes());
+
+            ASSERT_EQ(cc.find_components(G, &comp), paths);
+            ASSERT_EQ(scc.strong_components(G, &scc_comp), paths);
+
+            // both algorithms need to find the same partition
+            std::vector<int> mapping(paths, -1);
+            for (NodeID n : G->nodes()) {
+                if (mapping[comp[n]] == -1) {
+                    mapping[comp[n]] = scc_comp[n];
+                }
+                ASSERT_EQ(mapping[comp[n]], scc_comp[n]);
+            }
+
+            auto mG = mutable_graph::from_graph_access(G);
+            auto [m_comp, m_num] = cc.find_components(mG);
+            ASSERT_EQ(m_num, paths);
+            ASSERT_EQ(m_comp, comp);
+        }
+    }
+}
+
+TEST(ConnectedComponentsTest, LargestComponent) {
+    auto G = make_paths(3, 100);
+    auto H = std::make_shared<graph_access>();
+    // add a fourth, larger path
+    auto large = make_paths(1, 150);
+    H->start_construction(G->number_of_nodes() + large->number_of_nodes(),
+                          G->number_of_edges() + large->number_of_edges());
+    for (NodeID n : G->nodes()) {
+        H->new_node();
+        for (EdgeID e : G->edges_of(n)) {
+            H->new_edge(n, G->getEdgeTarget(e));
+        }
+    }
+    for (NodeID n : large->nodes()) {
+        H->new_node();
+        for (EdgeID e : large->edges_of(n)) {
+            H->new_edge(n + G->number_of_nodes(),
+                        large->getEdgeTarget(e) + G->number_of_nodes());
+        }
+    }
+    H->finish_construction();
+
+    connected_components cc;
+    auto out = cc.largest_cc(H);
+    ASSERT_EQ(out->number_of_nodes(), 150);
+    ASSERT_EQ(out->number_of_edges(), large->number_of_edges());
+}
+
+TEST(ConnectedComponentsTest, ExtractAllComponents) {
+    for (int threads : { 1, 4 }) {
+        omp_set_num_threads(threads);
+        auto G = make_paths(7, 1000);
+        auto mG = mutable_graph::from_graph_access(G);
+        connected_components cc;
+        auto [comp, num_comp] = cc.find_components(mG);
+        ASSERT_EQ(num_comp, 7);
+
+        graph_extractor ge;
+        std::vector<bool> extract(num_comp, true);
+        extract[3] = false;
+        auto [blocks, new_id] =
+            ge.extract_blocks(G, comp, num_comp, extract);
+        auto [m_blocks, m_new_id] =
+            ge.extract_blocks(mG, comp, num_comp, extract);
+        ASSERT_EQ(new_id, m_new_id);
+        ASSERT_EQ(blocks[3], nullptr);
+        ASSERT_EQ(m_blocks[3], nullptr);
+
+        std::vector<std::vector<NodeID> > old_id(num_comp);
+        for (NodeID n : G->nodes()) {
+            ASSERT_EQ(new_id[n], old_id[comp[n]].size());
+            old_id[comp[n]].emplace_back(n);
+        }
+
+        for (size_t c = 0; c < num_comp; ++c) {
+            if (!extract[c])
+                continue;
+
+            auto B = blocks[c];
+            auto mB = m_blocks[c];
+            ASSERT_EQ(B->number_of_nodes(), old_id[c].size());
+            ASSERT_EQ(mB->number_of_nodes(), old_id[c].size());
+            for (NodeID n : B->nodes()) {
+                NodeID o = old_id[c][n];
+                ASSERT_EQ(B->getNodeDegree(n), G->getNodeDegree(o));
+                ASSERT_EQ(mB->get_first_invalid_edge(n),
+                          mG->get_first_invalid_edge(o));
+                ASSERT_EQ(mB->getWeightedNodeDegree(n),
+                          mG->getWeightedNodeDegree(o));
+                for (EdgeID e : B->edges_of(n)) {
+                    NodeID t = B->getEdgeTarget(e);
+                    ASSERT_EQ(old_id[c][t],
+                              G->getEdgeTarget(G->get_first_edge(o)
+                                               + e - B->get_first_edge(n)));
+                }
+                for (EdgeID e : mB->edges_of(n)) {
+                    NodeID t = mB->getEdgeTarget(n, e);
+                    EdgeID rev = mB->getReverseEdge(n, e);
+                    ASSERT_EQ(mB->getEdgeTarget(t, rev), n);
+                }
+            }
+        }
+    }
+}
@@ -9,6 +9,9 @@
  * Published under the MIT license in the LICENSE file.
  *****************************************************************************/
 
+#include <omp.h>
+
+#include <memory>
 #include <type_traits>
 
 #include "data_structure/flow_graph.h"
@@ -101,3 +104,38 @@ TEST(FlowGraphTest, SparseGraph) {
         }
     }
 }
+
+TEST(FlowGraphTest, ReverseEdges) {
+    for (int threads : { 1, 4 }) {
+        omp_set_num_threads(threads);
+        std::shared_ptr<graph_access> G = std::make_shared<graph_access>();
+        G->start_construction(100, 0);
+        for (size_t i = 0; i < 100; ++i) {
+            G->new_node();
+            for (size_t j = 1; j < 10; ++j) {
+                G->new_edge(i, (i * j + 7) % 100, i + j);
+            }
+        }
+        G->finish_construction();
+        std::shared_ptr<flow_graph> fG = graph_io::createFlowGraph(G);
+        ASSERT_EQ(fG->number_of_edges(), 1800);
+
+        for (NodeID n : fG->nodes()) {
+            FlowType capacity = 0;
+            EdgeID forward = 0;
+            for (EdgeID e : fG->edges_of(n)) {
+                NodeID tgt = fG->getEdgeTarget(n, e);
+                EdgeID rev = fG->getReverseEdge(n, e);
+                ASSERT_EQ(fG->getEdgeTarget(tgt, rev), n);
+                ASSERT_EQ(fG->getReverseEdge(tgt, rev), e);
+                // exactly one of both directions has capacity
+                ASSERT_EQ(fG->getEdgeCapacity(n, e) == 0,
+                          fG->getEdgeCapacity(tgt, rev) > 0);
+                capacity += fG->getEdgeCapacity(n, e);
+                forward += (fG->getEdgeCapacity(n, e) > 0);
+            }
+            ASSERT_EQ(fG->getCapacity(n), capacity);
+            ASSERT_EQ(forward, 9);
+        }
+    }
+}
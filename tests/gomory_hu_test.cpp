@@ -0,0 +1,104 @@
+/******************************************************************************
+ * gomory_hu_test.cpp
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#include <omp.h>
+
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "algorithms/flow/gomory_hu.h"
+#include "algorithms/flow/push_relabel.h"
+#include "data_structure/gomory_hu_tree.h"
+#include "data_structure/mutable_graph.h"
+#include "gtest/gtest.h"
+#include "tests/test_graphs.h"
+
+TEST(GomoryHuTest, ConnectivityQueries) {
+    std::mt19937 eng(3);
+    for (int threads : { 1, 4 }) {
+        omp_set_num_threads(threads);
+        for (NodeID n : { 2, 10, 40 }) {
+            // the sparse graph is disconnected
+            for (EdgeID m : { n / 2, 3 * n }) {
+                auto G = randomGraph(n, m, &eng);
+                gomory_hu gh;
+                auto tree = gh.buildTree(G);
+                ASSERT_EQ(tree->number_of_nodes(), n);
+
+                push_relabel pr;
+                for (NodeID u = 0; u < n; ++u) {
+                    ASSERT_EQ(tree->connectivity(u, u),
+                              std::numeric_limits<EdgeWeight>::max());
+                    for (NodeID v = u + 1; v < n; ++v) {
+                        std::vector<NodeID> terminals = { u, v };
+                        FlowType flow = pr.solve_max_flow_min_cut(
+                            G, terminals, 0, false, true).first;
+                        ASSERT_EQ(tree->connectivity(u, v), flow);
+                        ASSERT_EQ(tree->connectivity(v, u), flow);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(GomoryHuTest, TreeEdgesAreCuts) {
+    std::mt19937 eng(5);
+    auto G = randomGraph(60, 200, &eng);
+    gomory_hu gh;
+    auto tree = gh.buildTree(G);
+
+    for (NodeID v = 1; v < tree->number_of_nodes(); ++v) {
+        // subtree of v after removing the edge to its parent
+        std::vector<bool> in_subtree(G->n(), false);
+        for (NodeID u = 0; u < G->n(); ++u) {
+            NodeID a = u;
+            while (a != 0 && a != v) {
+                a = tree->getParent(a);
+            }
+            in_subtree[u] = (a == v);
+        }
+
+        EdgeWeight cut = 0;
+        for (NodeID u : G->nodes()) {
+            for (EdgeID e : G->edges_of(u)) {
+                if (in_subtree[u] && !in_subtree[G->getEdgeTarget(u, e)]) {
+                    cut += G->getEdgeWeight(u, e);
+                }
+            }
+        }
+        ASSERT_EQ(cut, tree->getParentWeight(v));
+    }
+}
+
+TEST(GomoryHuTest, WriteAndRead) {
+    std::mt19937 eng(11);
+    auto G = randomGraph(30, 90, &eng);
+    gomory_hu gh;
+    auto tree = gh.buildTree(G);
+
+    std::string filename = std::string(VIECUT_PATH) + "/tmp_gomory_hu_tree";
+    tree->writeTree(filename);
+    auto read = gomory_hu_tree::readTree(filename);
+    std::remove(filename.c_str());
+
+    ASSERT_EQ(read->number_of_nodes(), tree->number_of_nodes());
+    for (NodeID u = 0; u < tree->number_of_nodes(); ++u) {
+        ASSERT_EQ(read->getParent(u), tree->getParent(u));
+        for (NodeID v = 0; v < tree->number_of_nodes(); ++v) {
+            ASSERT_EQ(read->connectivity(u, v), tree->connectivity(u, v));
+        }
+    }
+}
@@ -0,0 +1,65 @@
+/******************************************************************************
+ * isolating_cuts_test.cpp
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "algorithms/flow/isolating_cuts.h"
+#include "algorithms/flow/push_relabel.h"
+#include "data_structure/mutable_graph.h"
+#include "gtest/gtest.h"
+#include "tests/test_graphs.h"
+
+TEST(IsolatingCutsTest, MatchesSingleFlows) {
+    std::mt19937 eng(7);
+    for (NodeID n : { 10, 50, 200 }) {
+        for (NodeID k : { 1, 2, 3, 5, 8 }) {
+            auto G = randomGraph(n, 4 * n, &eng);
+            std::vector<NodeID> terminals;
+            for (NodeID i = 0; i < k; ++i) {
+                terminals.emplace_back(i * (n / k));
+            }
+
+            isolating_cuts ic;
+            auto cuts = ic.computeIsolatingCuts(G, terminals);
+            ASSERT_EQ(cuts.size(), k);
+
+            std::vector<NodeID> owner(n, UNDEFINED_NODE);
+            for (NodeID i = 0; i < k; ++i) {
+                for (NodeID v : cuts[i]) {
+                    // the cuts are disjoint
+                    ASSERT_EQ(owner[v], UNDEFINED_NODE);
+                    owner[v] = i;
+                }
+                ASSERT_EQ(owner[terminals[i]], i);
+            }
+
+            if (k < 2)
+                continue;
+
+            push_relabel pr;
+            for (NodeID i = 0; i < k; ++i) {
+                FlowType cut = 0;
+                for (NodeID v : cuts[i]) {
+                    for (EdgeID e : G->edges_of(v)) {
+                        if (owner[G->getEdgeTarget(v, e)] != i) {
+                            cut += G->getEdgeWeight(v, e);
+                        }
+                    }
+                }
+                FlowType flow = pr.solve_max_flow_min_cut(
+                    G, terminals, i, false, true).first;
+                ASSERT_EQ(cut, flow);
+            }
+        }
+    }
+}
@@ -9,12 +9,64 @@
  * Published under the MIT license in the LICENSE file.
  *****************************************************************************/
 
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 #include "algorithms/multicut/multiterminal_cut.h"
 #include "gperftools/malloc_extension.h"
 #include "gtest/gtest.h"
 #include "io/graph_io.h"
+#include "tests/test_graphs.h"
+
+// sets a configuration value for the lifetime of the guard, the previous
+// value is restored when the guard is destroyed
+template <typename T>
+class config_guard {
+ public:
+    config_guard(T* value, T temporary) : value(value), saved(*value) {
+        *value = temporary;
+    }
+
+    ~config_guard() {
+        *value = saved;
+    }
+
+ private:
+    T* value;
+    T  saved;
+};
+
+// terminals of the graphs of addClusteredGraph, one in every cluster
+static const std::vector<NodeID> clustered_terminals = {
+    0, 45, 90, 135, 180
+};
+
+// adds a random graph on the vertices [offset, offset + 200) to G, which
+// is under construction. most of the 800 edges are inside of one of 5
+// clusters of 40 vertices. the same seed always gives the same graph
+static void addClusteredGraph(mutable_graph* G, size_t seed,
+                              NodeID offset = 0) {
+    std::mt19937 eng(seed);
+    std::uniform_int_distribution<NodeID> vertex(0, 199);
+    for (size_t i = 0; i < 800; ++i) {
+        NodeID u = vertex(eng);
+        NodeID v = (i % 4) ? (u / 40) * 40 + vertex(eng) % 40 : vertex(eng);
+        G->new_edge_order(u + offset, v + offset, 1 + i % 5);
+    }
+}
+
+static std::shared_ptr<mutable_graph> clusteredGraph(size_t seed) {
+    auto G = std::make_shared<mutable_graph>();
+    G->start_construction(200);
+    addClusteredGraph(G.get(), seed);
+    G->finish_construction();
+    return G;
+}
 
 TEST(MultiterminalCutTest, FourClusters) {
     std::vector<size_t> sizes = { 5, 10, 50, 100 };
@@ -234,3 +286,394 @@ TEST(MultiterminalCutTest, PartiallyDisconnected) {
         ASSERT_EQ(f, (FlowType)2);
     }
 }
+
+TEST(MultiterminalCutTest, ClusteredGraphIsolatingCuts) {
+    auto cfg = configuration::getConfig();
+    for (size_t seed : { 7, 11, 13 }) {
+        auto G = clusteredGraph(seed);
+        std::vector<NodeID> terminals = clustered_terminals;
+        multiterminal_cut mct;
+        FlowType f = mct.multicut(G, terminals);
+
+        // same multicut if the isolating cuts are computed with O(log k)
+        // flows instead of one flow per terminal
+        config_guard<bool> isolating_cuts(&cfg->use_isolating_cuts, true);
+        multiterminal_cut mct_isolating;
+        ASSERT_EQ(mct_isolating.multicut(G, terminals), f);
+    }
+}
+
+TEST(MultiterminalCutTest, ParallelKernelization) {
+    // without the noi rule, which starts at a random vertex
+    for (size_t contraction_type : { 1, 2, 3 }) {
+        for (size_t seed : { 17, 19 }) {
+            std::vector<std::shared_ptr<multicut_problem> > problems;
+            for (size_t threads : { 1, 4 }) {
+                auto G = clusteredGraph(seed);
+                std::vector<terminal> terminals;
+                for (size_t i = 0; i < clustered_terminals.size(); ++i) {
+                    terminals.emplace_back(clustered_terminals[i], i);
+                }
+                auto problem = std::make_shared<multicut_problem>(G,
+                                                                  terminals);
+                kernelization_criteria kc(contraction_type,
+                                          clustered_terminals);
+                kc.setParallelMinEdges(0);
+                kc.perform_kernelization(
+                    problem, std::numeric_limits<size_t>::max(), 0, threads);
+                problems.emplace_back(problem);
+            }
+
+            auto seq = problems[0]->graph;
+            auto par = problems[1]->graph;
+            ASSERT_LT(seq->n(), (NodeID)200);
+            ASSERT_EQ(seq->n(), par->n());
+            ASSERT_EQ(seq->m(), par->m());
+            ASSERT_EQ(problems[0]->deleted_weight, problems[1]->deleted_weight);
+            for (NodeID n : seq->nodes()) {
+                ASSERT_EQ(seq->containedVertices(n), par->containedVertices(n));
+                ASSERT_EQ(seq->getNodeDegree(n), par->getNodeDegree(n));
+                for (EdgeID e : seq->edges_of(n)) {
+                    ASSERT_EQ(seq->getEdgeTarget(n, e),
+                              par->getEdgeTarget(n, e));
+                    ASSERT_EQ(seq->getEdgeWeight(n, e),
+                              par->getEdgeWeight(n, e));
+                }
+            }
+        }
+    }
+}
+
+TEST(MultiterminalCutTest, MappingChainFolding) {
+    NodeID n = 1024;
+    multicut_problem problem;
+    std::vector<NodeID> expected(n);
+    for (NodeID v = 0; v < n; ++v) {
+        expected[v] = v;
+    }
+
+    // every map halves the number of vertices
+    for (NodeID size = n; size > 1; size /= 2) {
+        auto map = std::make_shared<std::vector<NodeID> >(size);
+        for (NodeID v = 0; v < size; ++v) {
+            (*map)[v] = v / 2;
+        }
+        auto before = problem.mappings;
+        std::vector<NodeID> before_front;
+        if (before.size()) {
+            before_front = *before.front();
+        }
+        problem.addMapping(map);
+
+        ASSERT_LE(problem.mappings.size(), multicut_problem::max_mapping_depth);
+        for (NodeID v = 0; v < n; ++v) {
+            expected[v] /= 2;
+            ASSERT_EQ(problem.mapped(v), expected[v]);
+        }
+        // maps shared with other problems are not modified
+        if (before.size()) {
+            ASSERT_EQ(*before.front(), before_front);
+        }
+    }
+}
+
+TEST(MultiterminalCutTest, SpillProblemToDisk) {
+    std::mt19937 eng(17);
+    auto G = randomGraph(100, 400, &eng);
+    for (NodeID v = 0; v < 10; ++v) {
+        G->contractEdge(v, 0);
+    }
+
+    auto problem = std::make_shared<multicut_problem>(G);
+    problem->terminals = { terminal(0, 0, false), terminal(5, 1, true) };
+    problem->lower_bound = 12;
+    problem->upper_bound = 34;
+    problem->deleted_weight = 5;
+    problem->path = "01";
+    // pending modifications are written with the unmodified graph
+    problem->delta.emplace_back(graph_delta::delete_edge, 3, 1);
+    NodeID delta_target = G->getEdgeTarget(3, 1);
+
+    disk_problem_queue disk(VIECUT_PATH);
+    disk.addProblem(problem);
+    ASSERT_EQ(disk.size(), 1);
+    auto read = disk.pullProblem();
+    ASSERT_TRUE(disk.empty());
+    ASSERT_EQ(disk.pullProblem(), nullptr);
+
+    ASSERT_EQ(read->lower_bound, 12);
+    ASSERT_EQ(read->upper_bound, 34);
+    ASSERT_EQ(read->deleted_weight, 5);
+    ASSERT_EQ(read->path, "01");
+    ASSERT_EQ(read->terminals.size(), 2);
+    ASSERT_EQ(read->terminals[1].original_id, 1);
+    ASSERT_TRUE(read->terminals[1].invalid_flow);
+
+    auto S = G->simplify();
+    ASSERT_EQ(read->graph->n(), S->n());
+    ASSERT_EQ(read->graph->m(), S->m());
+    for (NodeID v : S->nodes()) {
+        ASSERT_EQ(read->graph->get_first_invalid_edge(v),
+                  S->get_first_invalid_edge(v));
+        for (EdgeID e : S->edges_of(v)) {
+            ASSERT_EQ(read->graph->getEdgeTarget(v, e),
+                      S->getEdgeTarget(v, e));
+            ASSERT_EQ(read->graph->getEdgeWeight(v, e),
+                      S->getEdgeWeight(v, e));
+        }
+    }
+    for (NodeID v = 0; v < 100; ++v) {
+        ASSERT_EQ(read->mapped(v), G->getCurrentPosition(v));
+    }
+    ASSERT_EQ(read->delta.size(), 1);
+    ASSERT_EQ(read->delta[0].op, graph_delta::delete_edge);
+    ASSERT_EQ(read->delta[0].vertex, 3);
+    ASSERT_EQ(read->graph->getEdgeTarget(3, read->delta[0].edge),
+              delta_target);
+}
+
+TEST(MultiterminalCutTest, ClusteredGraphNoMemory) {
+    auto cfg = configuration::getConfig();
+    for (size_t seed : { 3, 5 }) {
+        auto G = clusteredGraph(seed);
+        std::vector<NodeID> terminals = clustered_terminals;
+        multiterminal_cut mct;
+        FlowType f = mct.multicut(G, terminals);
+
+        // all problems in the queues are spilled to disk
+        config_guard<size_t> memory_budget(&cfg->memory_budget, 0);
+        config_guard<std::string> spill_path(&cfg->spill_path, VIECUT_PATH);
+        multiterminal_cut mct_spill;
+        ASSERT_EQ(mct_spill.multicut(G, terminals), f);
+        ASSERT_GT(mct_spill.numSpilled(), 0);
+        ASSERT_GT(mct_spill.numReloaded(), 0);
+    }
+}
+
+TEST(MultiterminalCutTest, SplitIntoComponents) {
+    // two random clustered graphs that are only connected by an edge
+    // between two terminals. the edge is in every multicut, after deleting
+    // it the problem is split into the two graphs
+    auto G = std::make_shared<mutable_graph>();
+    G->start_construction(400);
+    addClusteredGraph(G.get(), 29);
+    addClusteredGraph(G.get(), 29, 200);
+    G->new_edge(0, 200, 100);
+    G->finish_construction();
+    auto H = clusteredGraph(29);
+
+    std::vector<NodeID> terminals_h = clustered_terminals;
+    std::vector<NodeID> terminals_g = terminals_h;
+    for (NodeID t : terminals_h) {
+        terminals_g.emplace_back(t + 200);
+    }
+
+    config_guard<size_t> threads_guard(&configuration::getConfig()->threads,
+                                       1);
+    for (size_t threads : { 1, 4 }) {
+        configuration::getConfig()->threads = threads;
+        multiterminal_cut mct;
+        FlowType f_h = mct.multicut(H, terminals_h);
+        FlowType f_g = mct.multicut(G, terminals_g);
+        ASSERT_EQ(f_g, 2 * f_h + 100);
+    }
+}
+
+TEST(MultiterminalCutTest, ResumeFromCheckpoint) {
+    auto cfg = configuration::getConfig();
+    std::string checkpoint = std::string(VIECUT_PATH) + "/tmp_checkpoint";
+    auto G = clusteredGraph(23);
+    std::vector<NodeID> terminals = clustered_terminals;
+
+    multiterminal_cut mct;
+    FlowType f = mct.multicut(G, terminals);
+
+    // the first run writes a checkpoint when it hits the time limit
+    config_guard<std::string> checkpoint_file(&cfg->checkpoint_file,
+                                              checkpoint);
+    {
+        config_guard<double> time_limit(&cfg->time_limit, 0);
+        multiterminal_cut mct_timeout;
+        mct_timeout.multicut(G, terminals);
+        ASSERT_TRUE(mct_timeout.timedOut());
+    }
+    ASSERT_FALSE(mct.timedOut());
+
+    config_guard<bool> resume(&cfg->resume, true);
+    multiterminal_cut mct_resume;
+    ASSERT_EQ(mct_resume.multicut(G, terminals), f);
+    std::remove(checkpoint.c_str());
+}
+
+TEST(MultiterminalCutTest, TranspositionTable) {
+    auto cfg = configuration::getConfig();
+    auto G = clusteredGraph(31);
+    std::vector<NodeID> terminals = clustered_terminals;
+
+    config_guard<size_t> log_size_guard(&cfg->transposition_log_size, 0);
+    config_guard<size_t> threads_guard(&cfg->threads, 1);
+    multiterminal_cut mct;
+    FlowType f = mct.multicut(G, terminals);
+
+    // a tiny table, so that entries are replaced
+    for (size_t log_size : { 4, 20 }) {
+        for (size_t threads : { 1, 4 }) {
+            cfg->transposition_log_size = log_size;
+            cfg->threads = threads;
+            multiterminal_cut mct_table;
+            ASSERT_EQ(mct_table.multicut(G, terminals), f);
+        }
+    }
+}
+
+TEST(MultiterminalCutTest, TranspositionHashUpdate) {
+    auto G = clusteredGraph(41)->simplify();
+    auto problem = std::make_shared<multicut_problem>(G);
+    transposition_table::hashGraph(problem.get());
+
+    // the updated hash is the same as the hash of the graph from scratch
+    std::mt19937 eng(43);
+    for (size_t i = 0; i < 100 && G->m(); ++i) {
+        std::uniform_int_distribution<NodeID> vertex(0, G->n() - 1);
+        NodeID v = vertex(eng);
+        if (!G->getNodeDegree(v))
+            continue;
+        EdgeID e = eng() % G->getNodeDegree(v);
+        if (i % 3) {
+            transposition_table::removeEndpoints(problem.get(), v, e);
+            NodeID kept = std::min(v, G->getEdgeTarget(v, e));
+            NodeID removed = G->contractEdge(v, e);
+            transposition_table::mergeEndpoints(problem.get(), kept, removed);
+            transposition_table::addVertex(problem.get(), kept);
+        } else {
+            transposition_table::deleteEdge(problem.get(), v, e);
+            G->deleteEdge(v, e);
+        }
+        ASSERT_TRUE(transposition_table::hasGraphHash(*problem));
+
+        multicut_problem scratch(G);
+        scratch.zobrist = problem->zobrist;
+        transposition_table::hashGraph(&scratch);
+        ASSERT_EQ(problem->graph_hash, scratch.graph_hash);
+        ASSERT_EQ(problem->graph_weight, scratch.graph_weight);
+        ASSERT_EQ(*problem->vertex_keys, *scratch.vertex_keys);
+    }
+}
+
+TEST(MultiterminalCutTest, EdgeCandidatesAfterDeletion) {
+    std::mt19937 eng(37);
+    auto G = randomGraph(100, 600, &eng);
+
+    auto problem = std::make_shared<multicut_problem>(G);
+    for (NodeID t : { 0, 30, 60, 90 }) {
+        problem->terminals.emplace_back(t, t);
+    }
+
+    // every selection has the heaviest neighbor of a terminal, also when
+    // the candidates are reused after deleting the selected edges
+    for (size_t i = 0; i < 40 && G->m(); ++i) {
+        EdgeWeight heaviest = 0;
+        for (const auto& t : problem->terminals) {
+            for (EdgeID e : G->edges_of(t.position)) {
+                NodeID tgt = G->getEdgeTarget(t.position, e);
+                heaviest = std::max(heaviest, G->getWeightedNodeDegree(tgt));
+            }
+        }
+        if (!heaviest)
+            break;
+
+        auto [v, e] = findEdge(problem, "heavy_vertex");
+        ASSERT_EQ(G->getWeightedNodeDegree(G->getEdgeTarget(v, e)),
+                  heaviest);
+        G->deleteEdge(v, e);
+    }
+}
+
+TEST(MultiterminalCutTest, EdgeCandidatesAfterContraction) {
+    std::vector<std::pair<std::string, edge_candidates::rule> > rules = {
+        { "heavy", edge_candidates::heavy },
+        { "heavy_global", edge_candidates::heavy_global },
+        { "distance", edge_candidates::distance },
+        { "heavy_vertex", edge_candidates::heavy_vertex }
+    };
+
+    for (const auto& [name, r] : rules) {
+        std::mt19937 eng(39);
+        auto G = randomGraph(100, 600, &eng);
+
+        auto problem = std::make_shared<multicut_problem>(G);
+        for (NodeID t : { 0, 30, 60, 90 }) {
+            problem->terminals.emplace_back(t, t);
+        }
+
+        // the selected edge has the best score, also when the candidates
+        // are updated after contracting the selected edges
+        for (size_t i = 0; i < 40 && G->m(); ++i) {
+            EdgeWeight best = 0;
+            for (NodeID n : G->nodes()) {
+                bool terminal = false;
+                for (const auto& t : problem->terminals) {
+                    terminal |= (t.position == n);
+                }
+                for (EdgeID e : G->edges_of(n)) {
+                    if (terminal || r == edge_candidates::heavy_global) {
+                        best = std::max(best,
+                                        edge_candidates::score(G, r, n, e));
+                    }
+                }
+            }
+            if (!best)
+                break;
+
+            auto [v, e] = findEdge(problem, name);
+            ASSERT_EQ(edge_candidates::score(G, r, v, e), best);
+
+            NodeID tgt = G->getEdgeTarget(v, e);
+            bool between_terminals = false;
+            for (const auto& t : problem->terminals) {
+                for (const auto& u : problem->terminals) {
+                    between_terminals |= (t.position == v
+                                          && u.position == tgt);
+                }
+            }
+            if (i % 2 || between_terminals) {
+                G->deleteEdge(v, e);
+            } else {
+                NodeID kept = std::min(v, tgt);
+                G->contractEdge(v, e);
+                for (auto& t : problem->terminals) {
+                    t.position = G->getCurrentPosition(t.original_id);
+                }
+                problem->candidates->contracted(problem, kept);
+            }
+        }
+    }
+}
+
+TEST(MultiterminalCutTest, PrimalHeuristic) {
+    auto cfg = configuration::getConfig();
+    auto G = clusteredGraph(41);
+    std::vector<NodeID> terminals = clustered_terminals;
+
+    config_guard<size_t> iterations_guard(&cfg->heuristic_iterations, 0);
+    config_guard<size_t> threads_guard(&cfg->threads, 1);
+    multiterminal_cut mct;
+    FlowType f = mct.multicut(G, terminals);
+
+    // the heuristic solution is a valid multiterminal cut
+    multicut_heuristic heuristic(G, terminals, 0);
+    std::vector<NodeID> block;
+    FlowType cut = heuristic.run(20, &block);
+    ASSERT_EQ(cut, heuristic.cutWeight(block));
+    ASSERT_GE(cut, f);
+    for (NodeID l = 0; l < terminals.size(); ++l) {
+        ASSERT_EQ(block[terminals[l]], l);
+    }
+
+    for (size_t threads : { 1, 4 }) {
+        cfg->heuristic_iterations = 20;
+        cfg->threads = threads;
+        multiterminal_cut mct_heuristic;
+        ASSERT_EQ(mct_heuristic.multicut(G, terminals), f);
+    }
+}
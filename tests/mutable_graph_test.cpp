@@ -9,7 +9,12 @@
  * Published under the MIT license in the LICENSE file.
  *****************************************************************************/
 
+#include <omp.h>
+
+#include <algorithm>
+#include <memory>
 #include <random>
+#include <utility>
 #include <vector>
 
 #include "data_structure/mutable_graph.h"
@@ -137,6 +142,106 @@ TEST(Mutable_Graph_Test, ToAndFromGraphAccess) {
     }
 }
 
+// lowers the vertex count above which mutable_graph builds and contracts
+// graphs in parallel, the default is restored when the guard is destroyed
+class parallel_threshold_guard {
+ public:
+    explicit parallel_threshold_guard(NodeID threshold) {
+        mutable_graph::setParallelThreshold(threshold);
+    }
+
+    ~parallel_threshold_guard() {
+        mutable_graph::setParallelThreshold(
+            mutable_graph::default_parallel_threshold);
+    }
+};
+
+void checkSameGraph(std::shared_ptr<mutable_graph> G,
+                    std::shared_ptr<mutable_graph> H) {
+    ASSERT_EQ(G->n(), H->n());
+    ASSERT_EQ(G->number_of_edges(), H->number_of_edges());
+    for (NodeID n : G->nodes()) {
+        ASSERT_EQ(G->getNodeDegree(n), H->getNodeDegree(n));
+        ASSERT_EQ(G->getWeightedNodeDegree(n), H->getWeightedNodeDegree(n));
+        ASSERT_EQ(G->containedVertices(n), H->containedVertices(n));
+        ASSERT_EQ(G->getPartitionIndex(n), H->getPartitionIndex(n));
+        for (EdgeID e : G->edges_of(n)) {
+            ASSERT_EQ(G->getEdgeTarget(n, e), H->getEdgeTarget(n, e));
+            ASSERT_EQ(G->getEdgeWeight(n, e), H->getEdgeWeight(n, e));
+            ASSERT_EQ(G->getReverseEdge(n, e), H->getReverseEdge(n, e));
+        }
+    }
+}
+
+TEST(Mutable_Graph_Test, ParallelEdgesFromGraphAccess) {
+    // random multigraph where every edge is inserted in both directions
+    std::mt19937 mt(42);
+    NodeID n = 500;
+    std::uniform_int_distribution<NodeID> dist(0, n - 1);
+    std::vector<std::vector<std::pair<NodeID, EdgeWeight> > > adj(n);
+    std::vector<std::vector<EdgeWeight> > wgt(n, std::vector<EdgeWeight>(n));
+    EdgeID m = 0;
+    for (size_t i = 0; i < 5000; ++i) {
+        NodeID u = dist(mt);
+        NodeID v = dist(mt);
+        EdgeWeight w = 1 + (i % 7);
+        adj[u].emplace_back(v, w);
+        adj[v].emplace_back(u, w);
+        if (u != v) {
+            wgt[u][v] += w;
+            wgt[v][u] += w;
+        }
+        m += 2;
+    }
+
+    auto GA = std::make_shared<graph_access>();
+    GA->start_construction(n, m);
+    for (NodeID v = 0; v < n; ++v) {
+        GA->new_node();
+        for (auto [t, w] : adj[v]) {
+            EdgeID e = GA->new_edge(v, t);
+            GA->setEdgeWeight(e, w);
+        }
+    }
+    GA->finish_construction();
+
+    // n is below the default threshold, so this graph is built sequentially
+    auto G_seq = mutable_graph::from_graph_access(GA);
+    parallel_threshold_guard guard(0);
+    for (int threads : { 1, 4 }) {
+        omp_set_num_threads(threads);
+        auto G = mutable_graph::from_graph_access(GA);
+        checkSameGraph(G_seq, G);
+        auto G2 = G->simplify();
+        ASSERT_EQ(G->number_of_nodes(), n);
+        ASSERT_EQ(G2->number_of_edges(), G->number_of_edges());
+
+        for (NodeID v : G->nodes()) {
+            EdgeWeight degree = 0;
+            for (EdgeID e : G->edges_of(v)) {
+                NodeID t = G->getEdgeTarget(v, e);
+                ASSERT_NE(t, v);
+                ASSERT_EQ(G->getEdgeWeight(v, e), wgt[v][t]);
+                ASSERT_EQ(G->getEdgeTarget(t, G->getReverseEdge(v, e)), v);
+                ASSERT_EQ(G2->getEdgeTarget(v, e), t);
+                ASSERT_EQ(G2->getReverseEdge(v, e), G->getReverseEdge(v, e));
+                degree += wgt[v][t];
+            }
+            ASSERT_EQ(G->getWeightedNodeDegree(v), degree);
+        }
+
+        auto GA2 = G->to_graph_access();
+        ASSERT_EQ(GA2->number_of_edges(), G->number_of_edges());
+        for (NodeID v : GA2->nodes()) {
+            for (EdgeID e : GA2->edges_of(v)) {
+                EdgeID e_mut = e - GA2->get_first_edge(v);
+                ASSERT_EQ(GA2->getEdgeTarget(e), G->getEdgeTarget(v, e_mut));
+                ASSERT_EQ(GA2->getEdgeWeight(e), G->getEdgeWeight(v, e_mut));
+            }
+        }
+    }
+}
+
 TEST(Mutable_Graph_Test, DeleteEdges) {
     mutable_graph G = make_circle();
 
@@ -286,6 +391,178 @@ TEST(Mutable_Graph_Test, LargerGraph) {
     }
 }
 
+TEST(Mutable_Graph_Test, CopyAfterContraction) {
+    // large enough that relocated adjacency lists trigger compaction
+    NodeID size = 200;
+    std::shared_ptr<mutable_graph> G = std::make_shared<mutable_graph>();
+    G->start_construction(size);
+    for (NodeID i = 0; i < size; ++i) {
+        for (NodeID j = 1; j <= 5; ++j) {
+            G->new_edge_order(i, (i + j) % size, 1);
+        }
+    }
+
+    std::mt19937 mt(42);
+    while (G->number_of_nodes() > 10) {
+        std::uniform_int_distribution<NodeID> dist(0, G->n() - 1);
+        NodeID v = dist(mt);
+        G->contractEdge(v, G->get_first_invalid_edge(v) - 1);
+
+        mutable_graph H(*G);
+        ASSERT_EQ(H.number_of_nodes(), G->number_of_nodes());
+        ASSERT_EQ(H.number_of_edges(), G->number_of_edges());
+        for (NodeID n : G->nodes()) {
+            ASSERT_EQ(H.get_first_invalid_edge(n),
+                      G->get_first_invalid_edge(n));
+            EdgeWeight degree = 0;
+            for (EdgeID e : G->edges_of(n)) {
+                NodeID t = G->getEdgeTarget(n, e);
+                ASSERT_EQ(H.getEdgeTarget(n, e), t);
+                ASSERT_EQ(H.getEdgeWeight(n, e), G->getEdgeWeight(n, e));
+                ASSERT_EQ(G->getEdgeTarget(t, G->getReverseEdge(n, e)), n);
+                degree += G->getEdgeWeight(n, e);
+            }
+            ASSERT_EQ(G->getWeightedNodeDegree(n), degree);
+        }
+    }
+
+    ASSERT_EQ(G->number_of_nodes(), 10);
+}
+
+// weight between contracted vertices is the sum of their original edges
+void checkContractedGraph(
+    std::shared_ptr<mutable_graph> G,
+    const std::vector<std::pair<NodeID, NodeID> >& original_edges) {
+    std::vector<std::vector<EdgeWeight> > weight(
+        G->n(), std::vector<EdgeWeight>(G->n(), 0));
+    for (auto [u, v] : original_edges) {
+        NodeID pu = G->getCurrentPosition(u);
+        NodeID pv = G->getCurrentPosition(v);
+        ASSERT_LT(pu, G->n());
+        ASSERT_LT(pv, G->n());
+        if (pu != pv) {
+            weight[pu][pv]++;
+            weight[pv][pu]++;
+        }
+    }
+
+    EdgeID num_edges = 0;
+    for (NodeID n : G->nodes()) {
+        EdgeWeight degree = 0;
+        for (EdgeID e : G->edges_of(n)) {
+            NodeID t = G->getEdgeTarget(n, e);
+            ASSERT_EQ(G->getEdgeTarget(t, G->getReverseEdge(n, e)), n);
+            ASSERT_EQ(G->getEdgeWeight(n, e), weight[n][t]);
+            degree += G->getEdgeWeight(n, e);
+        }
+        for (NodeID t : G->nodes()) {
+            num_edges += (weight[n][t] > 0);
+        }
+        for (NodeID c : G->containedVertices(n)) {
+            ASSERT_EQ(G->getCurrentPosition(c), n);
+        }
+        ASSERT_EQ(G->getWeightedNodeDegree(n), degree);
+    }
+    ASSERT_EQ(G->number_of_edges(), num_edges);
+}
+
+TEST(Mutable_Graph_Test, ContractVertexSet) {
+    NodeID size = 200;
+    std::shared_ptr<mutable_graph> G = std::make_shared<mutable_graph>();
+    G->start_construction(size);
+    std::vector<std::pair<NodeID, NodeID> > original_edges;
+    for (NodeID i = 0; i < size; ++i) {
+        for (NodeID j = 1; j <= 5; ++j) {
+            G->new_edge_order(i, (i + j) % size, 1);
+            original_edges.emplace_back(i, (i + j) % size);
+        }
+    }
+
+    std::mt19937 mt(42);
+    while (G->number_of_nodes() > 10) {
+        std::uniform_int_distribution<NodeID> dist(0, G->n() - 1);
+        // set may contain duplicates
+        std::vector<NodeID> vertex_set;
+        for (size_t i = 0; i < 4; ++i) {
+            vertex_set.emplace_back(dist(mt));
+        }
+        G->contractVertexSet(vertex_set);
+
+        checkContractedGraph(G, original_edges);
+    }
+}
+
+TEST(Mutable_Graph_Test, ContractPartition) {
+    NodeID size = 200;
+    std::shared_ptr<mutable_graph> G = std::make_shared<mutable_graph>();
+    G->start_construction(size);
+    std::vector<std::pair<NodeID, NodeID> > original_edges;
+    for (NodeID i = 0; i < size; ++i) {
+        for (NodeID j = 1; j <= 5; ++j) {
+            G->new_edge_order(i, (i + j) % size, 1);
+            original_edges.emplace_back(i, (i + j) % size);
+        }
+    }
+
+    std::mt19937 mt(42);
+    for (NodeID blocks : { 150, 40, 10, 1 }) {
+        std::uniform_int_distribution<NodeID> dist(0, blocks - 1);
+        std::vector<NodeID> mapping(G->n());
+        for (NodeID b = 0; b < blocks; ++b) {
+            // every block is non-empty
+            mapping[b] = b;
+        }
+        for (NodeID v = blocks; v < G->n(); ++v) {
+            mapping[v] = dist(mt);
+        }
+        std::shuffle(mapping.begin(), mapping.end(), mt);
+        G->contractPartition(mapping, blocks);
+
+        ASSERT_EQ(G->n(), blocks);
+        checkContractedGraph(G, original_edges);
+    }
+    ASSERT_EQ(G->number_of_edges(), 0);
+}
+
+TEST(Mutable_Graph_Test, ParallelContractPartition) {
+    NodeID size = 1000;
+    std::mt19937 mt(44);
+    std::uniform_int_distribution<NodeID> vertex(0, size - 1);
+    std::shared_ptr<mutable_graph> G_seq = std::make_shared<mutable_graph>();
+    G_seq->start_construction(size);
+    for (NodeID i = 0; i < 8 * size; ++i) {
+        NodeID u = vertex(mt);
+        NodeID v = vertex(mt);
+        if (u != v) {
+            G_seq->new_edge_order(u, v, 1 + i % 3);
+        }
+    }
+    G_seq->finish_construction();
+
+    for (int threads : { 1, 4 }) {
+        omp_set_num_threads(threads);
+        auto G = G_seq->simplify();
+        auto G_par = G_seq->simplify();
+        for (NodeID blocks : { 700, 200, 30, 1 }) {
+            std::uniform_int_distribution<NodeID> dist(0, blocks - 1);
+            std::vector<NodeID> mapping(G->n());
+            for (NodeID b = 0; b < blocks; ++b) {
+                mapping[b] = b;
+            }
+            for (NodeID v = blocks; v < G->n(); ++v) {
+                mapping[v] = dist(mt);
+            }
+            std::shuffle(mapping.begin(), mapping.end(), mt);
+            G->contractPartition(mapping, blocks);
+            {
+                parallel_threshold_guard guard(0);
+                G_par->contractPartition(mapping, blocks);
+            }
+            checkSameGraph(G, G_par);
+        }
+    }
+}
+
 TEST(Mutable_Graph_Test, DeleteVertices) {
     for (size_t size : { 5, 10, 50, 100 }) {
         std::shared_ptr<mutable_graph> G = std::make_shared<mutable_graph>();
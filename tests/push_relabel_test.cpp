@@ -429,3 +429,166 @@ TEST(PushRelabelTest, ContractSrcBlock) {
     ASSERT_EQ(f5, static_cast<FlowType>(1));
     ASSERT_EQ(src_block5.size(), 7);
 }
+
+TEST(PushRelabelTest, MinCutOnlyAndFullFlow) {
+    std::mt19937 eng(42);
+    push_relabel pr;
+    for (NodeID size : { 50, 200, 100 }) {
+        std::uniform_int_distribution<NodeID> vertex(0, size - 1);
+        std::uniform_int_distribution<EdgeWeight> weight(1, 10);
+        std::shared_ptr<mutable_graph> G = std::make_shared<mutable_graph>();
+        G->start_construction(size);
+        for (NodeID i = 0; i < 4 * size; ++i) {
+            NodeID u = vertex(eng);
+            NodeID v = vertex(eng);
+            if (u != v) {
+                G->new_edge(u, v, weight(eng));
+            }
+        }
+
+        std::vector<NodeID> terminals = { 0, size / 3, size / 2 };
+        for (NodeID src_v = 0; src_v < terminals.size(); ++src_v) {
+            auto [f, src_block] =
+                pr.solve_max_flow_min_cut(G, terminals, src_v, true);
+
+            // flow is a valid flow with value f
+            for (NodeID n : G->nodes()) {
+                FlowType out = 0;
+                for (EdgeID e : G->edges_of(n)) {
+                    FlowType flow = pr.getEdgeFlow(n, e);
+                    NodeID t = G->getEdgeTarget(n, e);
+                    ASSERT_LE(flow, (FlowType)G->getEdgeWeight(n, e));
+                    ASSERT_EQ(flow,
+                              -pr.getEdgeFlow(t, G->getReverseEdge(n, e)));
+                    out += flow;
+                }
+                if (n == terminals[src_v]) {
+                    ASSERT_EQ(out, f);
+                } else if (!vector::contains(terminals, n)) {
+                    ASSERT_EQ(out, 0);
+                }
+            }
+
+            auto [f_cut, src_block_cut] =
+                pr.solve_max_flow_min_cut(G, terminals, src_v, true, true);
+            ASSERT_EQ(f, f_cut);
+            ASSERT_EQ(src_block, src_block_cut);
+        }
+    }
+}
+
+TEST(PushRelabelTest, ParallelFirstPhase) {
+    std::mt19937 eng(23);
+    push_relabel seq;
+    push_relabel par;
+    par.setParallelMinEdges(0);
+    for (NodeID size : { 50, 300, 1000 }) {
+        std::uniform_int_distribution<NodeID> vertex(0, size - 1);
+        std::uniform_int_distribution<EdgeWeight> weight(1, 10);
+        std::shared_ptr<mutable_graph> G = std::make_shared<mutable_graph>();
+        G->start_construction(size);
+        for (NodeID i = 0; i < 3 * size; ++i) {
+            NodeID u = vertex(eng);
+            NodeID v = vertex(eng);
+            if (u != v) {
+                G->new_edge(u, v, weight(eng));
+            }
+        }
+
+        std::vector<NodeID> terminals = { 1, size / 4, size / 2, size - 1 };
+        for (NodeID src_v = 0; src_v < terminals.size(); ++src_v) {
+            auto [f, src_block] =
+                seq.solve_max_flow_min_cut(G, terminals, src_v, true);
+            for (bool min_cut_only : { true, false }) {
+                auto [f_par, src_block_par] = par.solve_max_flow_min_cut(
+                    G, terminals, src_v, true, min_cut_only, 4);
+                ASSERT_EQ(f, f_par);
+                ASSERT_EQ(src_block, src_block_par);
+            }
+
+            // flow conservation of the full flow
+            for (NodeID n : G->nodes()) {
+                if (vector::contains(terminals, n))
+                    continue;
+                FlowType out = 0;
+                for (EdgeID e : G->edges_of(n)) {
+                    out += par.getEdgeFlow(n, e);
+                }
+                ASSERT_EQ(out, 0);
+            }
+        }
+    }
+}
+
+TEST(PushRelabelTest, WarmStartAfterContraction) {
+    std::mt19937 eng(7);
+    push_relabel pr;
+    for (NodeID size : { 50, 200, 500 }) {
+        std::uniform_int_distribution<NodeID> vertex(0, size - 1);
+        std::uniform_int_distribution<EdgeWeight> weight(1, 10);
+        std::shared_ptr<mutable_graph> G = std::make_shared<mutable_graph>();
+        G->start_construction(size);
+        for (NodeID i = 0; i < 3 * size; ++i) {
+            G->new_edge_order(vertex(eng), vertex(eng), weight(eng));
+        }
+
+        std::vector<NodeID> terminals = { 0, size / 3, size - 1 };
+        for (NodeID src_v = 0; src_v < terminals.size(); ++src_v) {
+            pr.solve_max_flow_min_cut(G, terminals, src_v, false);
+            auto snapshot = pr.saveFlow();
+
+            auto H = std::make_shared<mutable_graph>(*G);
+            for (size_t i = 0; i < 10; ++i) {
+                NodeID v = vertex(eng) % H->n();
+                if (!H->get_first_invalid_edge(v))
+                    continue;
+                std::uniform_int_distribution<EdgeID> edge(
+                    0, H->get_first_invalid_edge(v) - 1);
+                EdgeID e = edge(eng);
+                NodeID t = H->getEdgeTarget(v, e);
+                bool terminal_v = false;
+                bool terminal_t = false;
+                for (NodeID term : terminals) {
+                    terminal_v |= (H->getCurrentPosition(term) == v);
+                    terminal_t |= (H->getCurrentPosition(term) == t);
+                }
+                if (i % 2 == 0 && !(terminal_v && terminal_t)) {
+                    H->contractEdge(v, e);
+                } else {
+                    H->deleteEdge(v, e);
+                }
+            }
+
+            std::vector<NodeID> current_terminals;
+            for (NodeID term : terminals) {
+                current_terminals.emplace_back(H->getCurrentPosition(term));
+            }
+
+            for (bool min_cut_only : { true, false }) {
+                auto [f, src_block] = pr.solve_max_flow_min_cut(
+                    H, current_terminals, src_v, true, min_cut_only);
+                auto [f_warm, src_block_warm] = pr.solve_max_flow_min_cut(
+                    H, current_terminals, src_v, true, min_cut_only,
+                    1, snapshot.get());
+                ASSERT_EQ(f, f_warm);
+                ASSERT_EQ(src_block, src_block_warm);
+
+                for (NodeID n : H->nodes()) {
+                    FlowType out = 0;
+                    for (EdgeID e : H->edges_of(n)) {
+                        FlowType flow = pr.getEdgeFlow(n, e);
+                        ASSERT_LE(flow, (FlowType)H->getEdgeWeight(n, e));
+                        out += flow;
+                    }
+                    if (!vector::contains(current_terminals, n)) {
+                        if (min_cut_only) {
+                            ASSERT_LE(out, 0);
+                        } else {
+                            ASSERT_EQ(out, 0);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,45 @@
+/******************************************************************************
+ * test_graphs.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <random>
+
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+
+// random graph with n vertices and at most m edges with weights in [1, 10].
+// self-loops and parallel edges are skipped
+inline std::shared_ptr<mutable_graph> randomGraph(NodeID n, EdgeID m,
+                                                  std::mt19937* eng) {
+    std::uniform_int_distribution<NodeID> vertex(0, n - 1);
+    std::uniform_int_distribution<EdgeWeight> weight(1, 10);
+    std::shared_ptr<mutable_graph> G = std::make_shared<mutable_graph>();
+    G->start_construction(n);
+    for (EdgeID i = 0; i < m; ++i) {
+        NodeID u = vertex(*eng);
+        NodeID v = vertex(*eng);
+        EdgeWeight w = weight(*eng);
+        if (u == v)
+            continue;
+
+        bool exists = false;
+        for (EdgeID e : G->edges_of(u)) {
+            exists |= (G->getEdgeTarget(u, e) == v);
+        }
+        if (!exists) {
+            G->new_edge_order(u, v, w);
+        }
+    }
+    G->finish_construction();
+    return G;
+}
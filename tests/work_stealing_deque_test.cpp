@@ -0,0 +1,79 @@
+/******************************************************************************
+ * work_stealing_deque_test.cpp
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2019 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "data_structure/work_stealing_deque.h"
+#include "gtest/gtest.h"
+
+TEST(WorkStealingDequeTest, OwnerIsLifoThiefIsFifo) {
+    std::vector<int> items(100);
+    work_stealing_deque<int> deque;
+    ASSERT_EQ(deque.take(), nullptr);
+    ASSERT_EQ(deque.steal(), nullptr);
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        deque.push(&items[i]);
+    }
+    ASSERT_EQ(deque.size(), items.size());
+
+    for (size_t i = 0; i < items.size() / 2; ++i) {
+        ASSERT_EQ(deque.take(), &items[items.size() - 1 - i]);
+        ASSERT_EQ(deque.steal(), &items[i]);
+    }
+    ASSERT_TRUE(deque.empty());
+    ASSERT_EQ(deque.take(), nullptr);
+}
+
+TEST(WorkStealingDequeTest, ConcurrentSteals) {
+    const size_t num_items = 100000;
+    const size_t num_thieves = 3;
+    std::vector<int> items(num_items);
+    std::vector<std::atomic<int> > taken(num_items);
+    for (auto& t : taken) {
+        t = 0;
+    }
+
+    work_stealing_deque<int> deque;
+    std::atomic<bool> done(false);
+    std::vector<std::thread> thieves;
+    for (size_t i = 0; i < num_thieves; ++i) {
+        thieves.emplace_back([&] {
+                while (!done || !deque.empty()) {
+                    int* item = deque.steal();
+                    if (item) {
+                        taken[item - items.data()]++;
+                    }
+                }
+            });
+    }
+
+    // owner pushes all items and takes some of them itself
+    for (size_t i = 0; i < num_items; ++i) {
+        deque.push(&items[i]);
+        if (i % 3 == 0) {
+            int* item = deque.take();
+            if (item) {
+                taken[item - items.data()]++;
+            }
+        }
+    }
+    done = true;
+    for (auto& t : thieves) {
+        t.join();
+    }
+
+    for (size_t i = 0; i < num_items; ++i) {
+        ASSERT_EQ(taken[i], 1);
+    }
+}